@@ -8,7 +8,8 @@ let currentEditingActionGroupNum = 0;
 let currentEditingRuleNum = 0;
 
 const dataTypesMap = {
-    0: 'DigitalInput', 1: 'DigitalOutput', 2: 'AnalogInput', 3: 'SoftIO', 4: 'Timer'
+    0: 'DigitalInput', 1: 'DigitalOutput', 2: 'AnalogInput', 3: 'SoftIO', 4: 'Timer',
+    5: 'Schedule'
 };
 const operationModeMap = {
     0: 'None',          // Default/Raw/Volatile
@@ -170,6 +171,57 @@ async function loadConfig() {
     }
 }
 
+// --- Live IOVariable State (WebSocket /live) ---
+// Binary frames, little-endian: uint8 kind, uint32 scan cycle, then per
+// changed slot: uint8 slot, uint8 bits (bit0 state, bit1 flag), int32 value.
+// Slots are indexes into currentConfig.ioVariables.
+let liveRenderPending = false;
+
+function connectLiveState() {
+    const protocol = location.protocol === 'https:' ? 'wss:' : 'ws:';
+    const socket = new WebSocket(`${protocol}//${location.host}/live`);
+    socket.binaryType = 'arraybuffer';
+    socket.onmessage = (event) => applyLiveFrame(new DataView(event.data));
+    // Device restarted, or all live slots taken: retry later
+    socket.onclose = () => setTimeout(connectLiveState, 3000);
+}
+
+function applyLiveFrame(view) {
+    const ioVariables = currentConfig.ioVariables;
+    if (!Array.isArray(ioVariables)) return;
+    for (let offset = 5; offset + 6 <= view.byteLength; offset += 6) {
+        const io = ioVariables[view.getUint8(offset)];
+        if (!io) continue;
+        const bits = view.getUint8(offset + 1);
+        io.st = (bits & 1) !== 0;
+        io.f = (bits & 2) !== 0;
+        io.v = view.getInt32(offset + 2, true);
+    }
+    if (liveRenderPending) return; // At most one redraw per animation frame
+    liveRenderPending = true;
+    requestAnimationFrame(() => {
+        liveRenderPending = false;
+        if (document.querySelector('.sortable-chosen')) return; // Mid-drag
+        populateIoVariables(currentConfig.ioVariables);
+    });
+}
+
+// Polls /storage until the device reports 'generation' saved. False if
+// the save failed or took longer than about 10 seconds.
+async function waitForStorage(generation) {
+    if (isNaN(generation)) return false;
+    for (let attempt = 0; attempt < 20; attempt++) {
+        try {
+            const storage = await (await fetch('/storage')).json();
+            if (storage.saved >= generation) return true;
+        } catch (error) {
+            // Rebooting after a WiFi change; the reload will tell
+        }
+        await new Promise(resolve => setTimeout(resolve, 500));
+    }
+    return false;
+}
+
 async function saveConfig() {
     // --- Get button reference ---
     const saveButton = document.getElementById('saveConfigBtn');
@@ -226,16 +278,24 @@ async function saveConfig() {
         clearTimeout(successTimer);
 
         if (response.ok) {
-            // SUCCESS: We actually got a 200 OK (less likely, but handle it)
+            // SUCCESS: the device applies the config without rebooting
+            // (only WiFi/device name changes still restart it)
             console.log("Received explicit OK response.");
-            saveButton.textContent = 'Config Saved, Rebooting...';
+            saveButton.textContent = 'Config Applied, Saving...';
             saveButton.classList.remove('btn-warning');
             saveButton.classList.add('btn-info'); // Blue/info color
 
-            // Schedule page refresh
+            // Flash is written in the background; wait for this generation
+            const reply = await response.text();
+            const generation = parseInt(reply.replace(/^\D+/, ''), 10);
+            if (await waitForStorage(generation)) {
+                saveButton.textContent = 'Config Saved';
+            }
+
+            // Reload to show the configuration as the device now has it
             setTimeout(() => {
                 location.reload();
-            }, 9000);
+            }, 1500);
 
         } else {
             // ERROR: Server responded with an error status (4xx, 5xx)
@@ -3714,6 +3774,7 @@ function initializeDragAndDrop() {
 
 document.addEventListener('DOMContentLoaded', () => {
     loadConfig(); // Load config when the page is ready
+    connectLiveState(); // Then keep IOVariable state/value/flag live
     const saveButton = document.getElementById('saveConfigBtn');
     if (saveButton) {
         saveButton.addEventListener('click', saveConfig);
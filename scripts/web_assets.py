@@ -0,0 +1,80 @@
+# PlatformIO pre-build script: builds the LittleFS image from a gzipped copy
+# of data/ so every web asset is stored and served compressed.
+#
+# Each file is written as <name>.gz (already compressed vendor files are
+# copied as-is) into $BUILD_DIR/webfs, which replaces data/ for buildfs and
+# uploadfs. The firmware takes each asset's ETag from its gzip trailer
+# (CRC32 and size of the uncompressed content); index.html references the
+# other assets with the same tag as ?v=, so they can be cached as immutable.
+
+import gzip
+import os
+import re
+import shutil
+import struct
+import zlib
+
+Import("env")  # noqa: F821
+
+SOURCE_DIR = env.subst("$PROJECT_DATA_DIR")  # noqa: F821
+OUTPUT_DIR = os.path.join(env.subst("$BUILD_DIR"), "webfs")  # noqa: F821
+INDEX_FILE = "index.html"
+ASSET_REF = re.compile(r'((?:href|src)="/)([^"?#]+)(")')
+
+
+def asset_tag(crc, size):
+    # Must match webAssetTag() in src/webAssets.cpp
+    return "%08x-%x" % (crc & 0xFFFFFFFF, size & 0xFFFFFFFF)
+
+
+def load_assets():
+    assets = {}  # URL name -> (content or None, compressed bytes or None, tag)
+    for name in sorted(os.listdir(SOURCE_DIR)):
+        path = os.path.join(SOURCE_DIR, name)
+        if not os.path.isfile(path) or name.startswith("."):
+            continue
+        with open(path, "rb") as f:
+            data = f.read()
+        if name.endswith(".gz"):
+            crc, size = struct.unpack("<II", data[-8:])
+            assets[name[:-3]] = (None, data, asset_tag(crc, size))
+        else:
+            assets[name] = (data, None, asset_tag(zlib.crc32(data), len(data)))
+    return assets
+
+
+def version_references(html, assets):
+    def replace(match):
+        name = match.group(2)
+        if name not in assets or name == INDEX_FILE:
+            return match.group(0)
+        return "%s%s?v=%s%s" % (match.group(1), name, assets[name][2],
+                                match.group(3))
+
+    return ASSET_REF.sub(replace, html.decode("utf-8")).encode("utf-8")
+
+
+def build_web_assets():
+    assets = load_assets()
+    if INDEX_FILE in assets and assets[INDEX_FILE][0] is not None:
+        html = version_references(assets[INDEX_FILE][0], assets)
+        assets[INDEX_FILE] = (html, None, None)
+
+    shutil.rmtree(OUTPUT_DIR, ignore_errors=True)
+    os.makedirs(OUTPUT_DIR)
+    raw_total = 0
+    gz_total = 0
+    for name, (content, compressed, _) in assets.items():
+        if compressed is None:
+            # mtime=0 keeps the output, and so the image, reproducible
+            compressed = gzip.compress(content, compresslevel=9, mtime=0)
+        with open(os.path.join(OUTPUT_DIR, name + ".gz"), "wb") as f:
+            f.write(compressed)
+        raw_total += struct.unpack("<I", compressed[-4:])[0]
+        gz_total += len(compressed)
+    print("Web assets: %d files, %d -> %d bytes gzipped"
+          % (len(assets), raw_total, gz_total))
+
+
+build_web_assets()
+env.Replace(PROJECT_DATA_DIR=OUTPUT_DIR)  # noqa: F821
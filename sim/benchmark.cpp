@@ -0,0 +1,176 @@
+// Host benchmark for the logic engine.
+//
+//   benchmark [--scans N] [config.json ...]
+//
+// Without config files a set of generated configurations from a single rule
+// up to MAX_RULES full groups is measured. Each run reports config load
+// (parse + compile) time, scans per second, ns per compiled rule, the
+// worst-case scan time, rules re-evaluated and events recorded per scan,
+// driven by pseudo-random virtual inputs on a 1 ms simulated scan period.
+// A scan is the firmware's runScanCycle() with the program running; the
+// scan task's image swap check, statistics and watchdog are not timed, and
+// virtual pins stand in for ADC DMA and the GPIO registers. The event ring
+// is drained outside the timed section, as the recorder task would.
+// Every config also goes through the upload validator, which reports its
+// estimated worst-case scan on the device and its errors/warnings; the
+// issues of config files are listed below their row.
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "configJson.h"
+#include "configValidator.h"
+#include "eventRing.h"
+#include "ruleEngine.h"
+#include "simScan.h"
+#include "timerService.h"
+
+#define DEFAULT_SCANS 200000
+#define SIM_SCAN_PERIOD_US 1000
+
+typedef std::chrono::steady_clock benchClock;
+
+static uint32_t lcgState = 12345;
+static uint32_t nextRandom() {
+  lcgState = lcgState * 1664525u + 1013904223u;
+  return lcgState >> 8;
+}
+
+static int64_t elapsedNs(benchClock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             benchClock::now() - start)
+      .count();
+}
+
+static void driveInputs() {
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    const IOVariable &io = IOVariables[i];
+    if (io.type == DigitalInput && (nextRandom() & 7) == 0) {
+      simSetDigitalPin(io.gpio, !simGetDigitalPin(io.gpio));
+    } else if (io.type == AnalogInput) {
+      simSetAnalogPin(io.gpio, nextRandom() & 0x0FFF);
+    }
+  }
+}
+
+static validationReport report;
+
+static void runBenchmark(const char *label, int64_t loadNs, uint32_t scans) {
+  defaultConfig.run = true;  // Whatever the config says, measure the rules
+  simConfigurePins();
+  resetRuleEngine();
+  lcgState = 12345;
+
+  static eventRecord drained[EVENT_RING_SIZE];
+  while (takeEvents(drained, EVENT_RING_SIZE) > 0) {
+  }
+  uint32_t recordedBefore = eventRingStats.recorded;
+
+  int64_t totalNs = 0;
+  int64_t worstNs = 0;
+  for (uint32_t s = 0; s < scans; s++) {
+    driveInputs();
+    simAdvanceMicros(SIM_SCAN_PERIOD_US);
+    benchClock::time_point start = benchClock::now();
+    simScanCycle();
+    int64_t ns = elapsedNs(start);
+    totalNs += ns;
+    if (ns > worstNs) worstNs = ns;
+    takeEvents(drained, EVENT_RING_SIZE);
+  }
+
+  double meanNs = (double)totalNs / scans;
+  const ruleProgram &program = *activeProgram;
+  double perRuleNs = program.ruleCount ? meanNs / program.ruleCount : 0.0;
+  double evalsPerScan = (double)ruleEngineStats.totalRuleEvals / scans;
+  double eventsPerScan =
+      (double)(eventRingStats.recorded - recordedBefore) / scans;
+  char issues[16];
+  snprintf(issues, sizeof(issues), "%u/%u", report.errors, report.warnings);
+  printf("%-28s %5u %5u %6u %10.1f %12.0f %10.1f %10.1f %10lld %10.2f "
+         "%11.2f %9u %7s\n",
+         label, program.ruleCount, program.conditionCount, program.length,
+         loadNs / 1000.0, 1e9 / meanNs, meanNs, perRuleNs, (long long)worstNs,
+         evalsPerScan, eventsPerScan,
+         (unsigned)(report.worstCaseCycles / WCET_CPU_MHZ), issues);
+}
+
+// Parses and compiles 'json', returning the time taken in ns. Validation
+// is not timed.
+static int64_t loadConfig(const String &json) {
+  benchClock::time_point start = benchClock::now();
+  parseJsonConfigString(json);
+  compileRuleProgram(*activeProgram);
+  int64_t loadNs = elapsedNs(start);
+  validateConfig(liveConfigView(), report);
+  return loadNs;
+}
+
+static void printHeader() {
+  printf("%-28s %5s %5s %6s %10s %12s %10s %10s %10s %10s %11s %9s %7s\n",
+         "config", "rules", "conds", "instr", "load[us]", "scans/s",
+         "mean[ns]", "ns/rule", "worst[ns]", "evals/scan", "events/scan",
+         "wcet[us]", "err/wrn");
+}
+
+int main(int argc, char **argv) {
+  uint32_t scans = DEFAULT_SCANS;
+  int firstFile = argc;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--scans") == 0 && i + 1 < argc) {
+      scans = strtoul(argv[++i], nullptr, 10);
+    } else {
+      firstFile = i;
+      break;
+    }
+  }
+  if (scans == 0) scans = 1;
+  startTimerService();
+
+  printf("Logic engine benchmark: profile %d, MAX_RULES=%d MAX_CONDITIONS=%d "
+         "MAX_ACTIONS=%d, %u-bit IDs, %u scans per config\n"
+         "Scan: latch, schedules, queued writes, rules, commit, process "
+         "image (firmware steps; not timed: swap check, statistics)\n",
+         CAPACITY_PROFILE, MAX_RULES, MAX_CONDITIONS, MAX_ACTIONS,
+         (unsigned)sizeof(logicId) * 8, scans);
+  printHeader();
+
+  if (firstFile < argc) {
+    for (int i = firstFile; i < argc; i++) {
+      std::ifstream file(argv[i]);
+      if (!file) {
+        fprintf(stderr, "Cannot open %s\n", argv[i]);
+        return 1;
+      }
+      std::stringstream content;
+      content << file.rdbuf();
+      CreateDefaultIOVariables();
+      InitializeDefaultLogicComponents();
+      int64_t loadNs = loadConfig(String(content.str()));
+      runBenchmark(argv[i], loadNs, scans);
+      printf("%s", validationText(report).c_str());
+    }
+    return 0;
+  }
+
+  const uint8_t sizes[][2] = {
+      {1, 1},
+      {5, 4},
+      {MAX_RULES / 2, MAX_CONDITIONS_PER_GROUP / 2},
+      {MAX_RULES, MAX_CONDITIONS_PER_GROUP},
+  };
+  for (const auto &size : sizes) {
+    buildSyntheticConfig(size[0], size[1]);
+    String json = generateJsonConfigString();  // Round trip through JSON
+    int64_t loadNs = loadConfig(json);
+    char label[40];
+    snprintf(label, sizeof(label), "generated %ux%u (%uB)", size[0], size[1],
+             (unsigned)json.length());
+    runBenchmark(label, loadNs, scans);
+  }
+  return 0;
+}
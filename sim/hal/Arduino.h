@@ -0,0 +1,151 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// Host-side stand-in for the parts of the Arduino core used by the logic
+// engine. Time comes from a simulated clock and GPIOs are virtual pins, so
+// runs are repeatable and independent of the host's scheduler.
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#define SIM_GPIO_COUNT 40
+
+#define constrain(amt, low, high) \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+
+// --- Simulated Clock ---
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);  // Advances the simulated clock
+void simAdvanceMicros(uint64_t us);  // Fires due esp_timer callbacks
+uint64_t simNowMicros();
+// --- End Simulated Clock ---
+
+// --- FreeRTOS critical sections (single-threaded simulation) ---
+typedef struct {
+  int unused;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+// --- End FreeRTOS critical sections ---
+
+// --- Virtual GPIO ---
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+uint16_t analogRead(uint8_t pin);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+void simSetDigitalPin(uint8_t pin, bool level);    // Drive an input
+bool simGetDigitalPin(uint8_t pin);                // Observe an output
+void simSetAnalogPin(uint8_t pin, uint16_t raw);   // 12-bit reading
+uint32_t simDigitalWriteCount();                   // HAL calls so far
+
+// Handlers run inside simSetDigitalPin() when the level change matches
+#define digitalPinToInterrupt(pin) (pin)
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg,
+                        int mode);
+void detachInterrupt(uint8_t pin);
+// --- End Virtual GPIO ---
+
+// --- CPU cycle counter (always 0 on the host) ---
+class EspClass {
+ public:
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 1000; }
+};
+
+extern EspClass ESP;
+// --- End CPU cycle counter ---
+
+// Not every host libc ships strlcpy
+size_t simStrlcpy(char *dst, const char *src, size_t size);
+#define strlcpy simStrlcpy
+
+// Minimal Arduino String: enough for the configuration code
+// (c_str/length/concat/+=).
+class String {
+ public:
+  String() {}
+  String(const char *s) { *this = s; }
+  String(const std::string &s) : data_(s) {}
+  String &operator=(const char *s) {
+    data_.assign(s ? s : "");
+    return *this;
+  }
+  const char *c_str() const { return data_.c_str(); }
+  size_t length() const { return data_.length(); }
+  bool reserve(size_t size) {
+    data_.reserve(size);
+    return true;
+  }
+  bool concat(const char *s) {
+    if (s) data_.append(s);
+    return true;
+  }
+  bool concat(const char *s, size_t len) {
+    data_.append(s, len);
+    return true;
+  }
+  bool concat(char c) {
+    data_.push_back(c);
+    return true;
+  }
+  String &operator+=(const char *s) {
+    concat(s);
+    return *this;
+  }
+  String &operator+=(const String &s) {
+    data_.append(s.data_);
+    return *this;
+  }
+  char operator[](size_t i) const { return data_[i]; }
+  bool operator==(const String &o) const { return data_ == o.data_; }
+
+ private:
+  std::string data_;
+};
+
+class StringSumHelper : public String {};
+
+// Serial output goes to stdout
+class SimSerial {
+ public:
+  void begin(unsigned long) {}
+  void print(const char *s) { fputs(s, stdout); }
+  void print(const String &s) { fputs(s.c_str(), stdout); }
+  void print(long v) { printf("%ld", v); }
+  void println() { fputs("\n", stdout); }
+  void println(const char *s) { printf("%s\n", s); }
+  void println(const String &s) { printf("%s\n", s.c_str()); }
+  void println(long v) { printf("%ld\n", v); }
+  template <typename... Args>
+  void printf(const char *fmt, Args... args) {
+    ::printf(fmt, args...);
+  }
+};
+
+extern SimSerial Serial;
+
+#endif  // SIM_ARDUINO_H
@@ -0,0 +1,19 @@
+#ifndef SIM_DRIVER_GPIO_H
+#define SIM_DRIVER_GPIO_H
+
+// Pin capability masks of the ESP32 (soc/soc_caps.h): GPIO 20, 24 and
+// 28-31 do not exist, 34-39 are input only.
+
+#include <stdint.h>
+
+#define SOC_GPIO_VALID_GPIO_MASK (0xFFFFFFFFFFULL & ~0xF1100000ULL)
+#define SOC_GPIO_VALID_OUTPUT_GPIO_MASK \
+  (SOC_GPIO_VALID_GPIO_MASK & ~(0x3FULL << 34))
+
+#define GPIO_IS_VALID_GPIO(n) \
+  ((n) >= 0 && (n) < 64 && ((1ULL << (n)) & SOC_GPIO_VALID_GPIO_MASK) != 0)
+#define GPIO_IS_VALID_OUTPUT_GPIO(n)   \
+  ((n) >= 0 && (n) < 64 &&             \
+   ((1ULL << (n)) & SOC_GPIO_VALID_OUTPUT_GPIO_MASK) != 0)
+
+#endif  // SIM_DRIVER_GPIO_H
@@ -0,0 +1,142 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include <vector>
+
+SimSerial Serial;
+EspClass ESP;
+
+// --- Simulated Clock ---
+struct simEspTimer {
+  esp_timer_create_args_t args;
+  uint64_t deadlineUs;
+  bool armed;
+};
+
+static uint64_t simMicros = 0;
+static std::vector<simEspTimer *> espTimers;
+
+unsigned long millis() { return (unsigned long)(simMicros / 1000); }
+unsigned long micros() { return (unsigned long)simMicros; }
+void delay(uint32_t ms) { simAdvanceMicros((uint64_t)ms * 1000); }
+uint64_t simNowMicros() { return simMicros; }
+
+void simAdvanceMicros(uint64_t us) {
+  uint64_t targetUs = simMicros + us;
+  for (;;) {
+    simEspTimer *due = nullptr;
+    for (simEspTimer *timer : espTimers) {
+      if (timer->armed && timer->deadlineUs <= targetUs &&
+          (due == nullptr || timer->deadlineUs < due->deadlineUs)) {
+        due = timer;
+      }
+    }
+    if (due == nullptr) break;
+    if (due->deadlineUs > simMicros) simMicros = due->deadlineUs;
+    due->armed = false;
+    due->args.callback(due->args.arg);
+  }
+  simMicros = targetUs;
+}
+
+int64_t esp_timer_get_time() { return (int64_t)simMicros; }
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args,
+                           esp_timer_handle_t *handle) {
+  simEspTimer *timer = new simEspTimer();
+  timer->args = *args;
+  timer->armed = false;
+  espTimers.push_back(timer);
+  *handle = timer;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs) {
+  if (timer->armed) return ESP_ERR_INVALID_STATE;
+  timer->deadlineUs = simMicros + timeoutUs;
+  timer->armed = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  if (!timer->armed) return ESP_ERR_INVALID_STATE;
+  timer->armed = false;
+  return ESP_OK;
+}
+// --- End Simulated Clock ---
+
+// --- Virtual GPIO ---
+static bool digitalPins[SIM_GPIO_COUNT];
+static uint16_t analogPins[SIM_GPIO_COUNT];
+static uint32_t digitalWrites = 0;
+
+struct simInterrupt {
+  void (*handler)(void *);
+  void *arg;
+  int mode;
+};
+static simInterrupt interrupts[SIM_GPIO_COUNT];
+
+void pinMode(uint8_t /* pin */, uint8_t /* mode */) {}
+
+int digitalRead(uint8_t pin) {
+  return (pin < SIM_GPIO_COUNT && digitalPins[pin]) ? HIGH : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin >= SIM_GPIO_COUNT) return;
+  digitalPins[pin] = (level != LOW);
+  digitalWrites++;
+}
+
+uint16_t analogRead(uint8_t pin) {
+  return pin < SIM_GPIO_COUNT ? analogPins[pin] : 0;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+void simSetDigitalPin(uint8_t pin, bool level) {
+  if (pin >= SIM_GPIO_COUNT || digitalPins[pin] == level) return;
+  digitalPins[pin] = level;
+  const simInterrupt &irq = interrupts[pin];
+  if (irq.handler != nullptr &&
+      (irq.mode == CHANGE || irq.mode == (level ? RISING : FALLING))) {
+    irq.handler(irq.arg);
+  }
+}
+
+bool simGetDigitalPin(uint8_t pin) {
+  return pin < SIM_GPIO_COUNT && digitalPins[pin];
+}
+
+void simSetAnalogPin(uint8_t pin, uint16_t raw) {
+  if (pin < SIM_GPIO_COUNT) analogPins[pin] = raw & 0x0FFF;
+}
+
+uint32_t simDigitalWriteCount() { return digitalWrites; }
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg,
+                        int mode) {
+  if (pin < SIM_GPIO_COUNT) interrupts[pin] = {handler, arg, mode};
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin < SIM_GPIO_COUNT) interrupts[pin].handler = nullptr;
+}
+// --- End Virtual GPIO ---
+
+// Rule profiles are not measured on the host: a clock read per rule would
+// cost more than the rule and distort the benchmark
+uint32_t EspClass::getCycleCount() { return 0; }
+
+size_t simStrlcpy(char *dst, const char *src, size_t size) {
+  size_t len = strlen(src);
+  if (size > 0) {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
@@ -0,0 +1,171 @@
+// Modbus TCP server on the host, for testing SCADA clients and the register
+// map against the real request handler (src/modbusProtocol.cpp).
+//
+//   modbusSim [--port N] [config.json]
+//
+// Listens on 127.0.0.1 (default port 1502; 502 needs root) and runs the
+// firmware scan cycle (src/scanCycle.h) every millisecond of wall time on
+// the simulated clock. A config file's run setting applies as on the
+// device; without a config file the generated 5x4 benchmark config is
+// served with the program running.
+// Virtual inputs stay at their initial levels.
+
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "configJson.h"
+#include "eventRing.h"
+#include "modbusProtocol.h"
+#include "ruleEngine.h"
+#include "simScan.h"
+#include "timerService.h"
+
+#define DEFAULT_PORT 1502
+#define SIM_MAX_CLIENTS 4
+#define SIM_SCAN_PERIOD_US 1000
+
+struct simConnection {
+  int fd;  // -1 = free
+  size_t received;
+  uint8_t frame[MODBUS_MAX_ADU];
+};
+
+static simConnection connections[SIM_MAX_CLIENTS];
+static uint8_t response[MODBUS_MAX_ADU];
+
+static int openListener(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  int yes = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(fd, (sockaddr *)&address, sizeof(address)) < 0 ||
+      listen(fd, SIM_MAX_CLIENTS) < 0) {
+    perror("modbusSim");
+    exit(1);
+  }
+  return fd;
+}
+
+static void acceptClient(int listener) {
+  int fd = accept(listener, nullptr, nullptr);
+  if (fd < 0) return;
+  for (simConnection &connection : connections) {
+    if (connection.fd >= 0) continue;
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    connection.fd = fd;
+    connection.received = 0;
+    modbusStats.connections++;
+    return;
+  }
+  modbusStats.refused++;
+  close(fd);
+}
+
+// Same framing as the firmware transport (src/modbusServer.cpp)
+static void readClient(simConnection &connection) {
+  ssize_t len = recv(connection.fd, connection.frame + connection.received,
+                     sizeof(connection.frame) - connection.received, 0);
+  if (len <= 0) {
+    close(connection.fd);
+    connection.fd = -1;
+    return;
+  }
+  connection.received += len;
+  size_t offset = 0;
+  for (;;) {
+    int length = modbusFrameLength(connection.frame + offset,
+                                   connection.received - offset);
+    if (length < 0) {
+      close(connection.fd);
+      connection.fd = -1;
+      return;
+    }
+    if (length == 0 || (size_t)length > connection.received - offset) break;
+    size_t answer =
+        handleModbusFrame(connection.frame + offset, length, response);
+    if (answer > 0) send(connection.fd, response, answer, 0);
+    offset += length;
+  }
+  connection.received -= offset;
+  memmove(connection.frame, connection.frame + offset, connection.received);
+}
+
+static void loadConfig(const char *path) {
+  std::ifstream file(path);
+  if (!file) {
+    fprintf(stderr, "Cannot open %s\n", path);
+    exit(1);
+  }
+  std::stringstream content;
+  content << file.rdbuf();
+  CreateDefaultIOVariables();
+  InitializeDefaultLogicComponents();
+  parseJsonConfigString(String(content.str()));
+}
+
+int main(int argc, char **argv) {
+  uint16_t port = DEFAULT_PORT;
+  const char *configPath = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+      port = atoi(argv[++i]);
+    } else {
+      configPath = argv[i];
+    }
+  }
+
+  startTimerService();
+  if (configPath != nullptr) {
+    loadConfig(configPath);
+  } else {
+    buildSyntheticConfig(5, 4);
+    defaultConfig.run = true;
+  }
+  compileRuleProgram(*activeProgram);
+  simConfigurePins();
+  resetRuleEngine();
+
+  for (simConnection &connection : connections) connection.fd = -1;
+  int listener = openListener(port);
+  printf("Modbus TCP on 127.0.0.1:%u, profile %d\n", port, CAPACITY_PROFILE);
+  fflush(stdout);
+
+  static eventRecord drained[EVENT_RING_SIZE];
+  for (;;) {
+    pollfd fds[SIM_MAX_CLIENTS + 1];
+    simConnection *owners[SIM_MAX_CLIENTS + 1];
+    nfds_t count = 0;
+    fds[count] = {listener, POLLIN, 0};
+    owners[count++] = nullptr;
+    for (simConnection &connection : connections) {
+      if (connection.fd < 0) continue;
+      fds[count] = {connection.fd, POLLIN, 0};
+      owners[count++] = &connection;
+    }
+    poll(fds, count, SIM_SCAN_PERIOD_US / 1000);
+    for (nfds_t i = 0; i < count; i++) {
+      if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+      if (owners[i] == nullptr) {
+        acceptClient(listener);
+      } else {
+        readClient(*owners[i]);
+      }
+    }
+
+    simAdvanceMicros(SIM_SCAN_PERIOD_US);
+    simScanCycle();
+    takeEvents(drained, EVENT_RING_SIZE);  // As the recorder task would
+  }
+}
@@ -0,0 +1,134 @@
+#include "simScan.h"
+
+#include <esp_timer.h>
+
+#include "analogInput.h"
+#include "inputCapture.h"
+#include "scanCycle.h"
+#include "scheduler.h"
+
+static uint32_t simCycles = 0;
+
+// The host has no ADC DMA; every AnalogInput goes through analogRead()
+analogReading readAnalogInput(uint8_t /* gpio */, int32_t & /* raw */) {
+  return ANALOG_NOT_SAMPLED;
+}
+
+void writeOutputPins(uint64_t high, uint64_t low) {
+  for (uint8_t pin = 0; pin < SIM_GPIO_COUNT; pin++) {
+    if (high & (1ULL << pin)) digitalWrite(pin, HIGH);
+    if (low & (1ULL << pin)) digitalWrite(pin, LOW);
+  }
+}
+
+void simConfigurePins() {
+  stopInputCapture();
+  for (uint8_t pin = 0; pin < SIM_GPIO_COUNT; pin++) {
+    detachInterrupt(pin);  // Handlers of a previously loaded config
+  }
+  configurePins();
+  startInputCapture();
+  buildSchedule(esp_timer_get_time());
+}
+
+void simScanCycle() { runScanCycle(esp_timer_get_time(), ++simCycles); }
+
+void buildSyntheticConfig(uint8_t ruleCount, uint8_t groupSize) {
+  CreateDefaultIOVariables();
+  InitializeDefaultLogicComponents();
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    IOVariables[i].status = true;
+    if (IOVariables[i].type == DigitalInput) {
+      IOVariables[i].mode = (operationMode)(i % 4);  // none/rising/falling/..
+    } else if (IOVariables[i].type == Timer) {
+      IOVariables[i].mode = (i % 2) ? repeating : oneShot;
+      IOVariables[i].value = 10 + i;  // Preset in ms
+    }
+  }
+  for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+    schedules[i].onMinute = 6 * 60;  // 06:00-18:00 every day
+    schedules[i].offMinute = 18 * 60;
+  }
+
+  // Conditions cycle over inputs, SoftIO values and Timer flags
+  for (logicId c = 0; c < MAX_CONDITIONS; c++) {
+    condition &cond = conditions[c];
+    cond.status = true;
+    switch (c % 4) {
+      case 0:
+        cond.Type = DigitalInput;
+        cond.targetNum = 1 + c % MAX_DIGITAL_IN;
+        cond.comp = isTrue;
+        break;
+      case 1:
+        cond.Type = DigitalInput;
+        cond.targetNum = 1 + c % MAX_DIGITAL_IN;
+        cond.comp = flagIsTrue;
+        break;
+      case 2:
+        cond.Type = SoftIO;
+        cond.targetNum = 1 + c % MAX_SOFTIO;
+        cond.comp = isGreater;
+        cond.value = c;
+        break;
+      default:
+        cond.Type = Timer;
+        cond.targetNum = 1 + c % MAX_TIMERS;
+        cond.comp = flagIsFalse;
+        break;
+    }
+  }
+
+  // Actions cycle over outputs, SoftIO counters and Timer starts
+  for (logicId a = 0; a < MAX_ACTIONS; a++) {
+    action &act = actions[a];
+    act.status = true;
+    switch (a % 4) {
+      case 0:
+      case 1:
+        act.Type = DigitalOutput;
+        act.targetNum = 1 + a % MAX_DIGITAL_OUT;
+        act.action = (a % 4 == 0) ? set : reset;
+        break;
+      case 2:
+        act.Type = SoftIO;
+        act.targetNum = 1 + a % MAX_SOFTIO;
+        act.action = increment;
+        act.value = 1;
+        break;
+      default:
+        act.Type = Timer;
+        act.targetNum = 1 + a % MAX_TIMERS;
+        act.action = set;
+        break;
+    }
+  }
+
+  uint16_t nextCondition = 0;
+  uint16_t nextAction = 0;
+  for (uint8_t r = 0; r < ruleCount && r < MAX_RULES; r++) {
+    bool grouped = r < MAX_CONDITION_GROUPS && r < MAX_ACTION_GROUPS;
+    rule &ru = rules[r];
+    ru.status = true;
+    ru.useConditionGroup = grouped && groupSize > 1;
+    ru.useActionGroup = grouped && groupSize > 1;
+    if (ru.useConditionGroup) {
+      conditionGroup &cg = conditionGroups[r];
+      cg.status = true;
+      cg.Logic = (r % 2) ? orLogic : andLogic;
+      for (uint8_t j = 0; j < groupSize && j < MAX_CONDITIONS_PER_GROUP; j++) {
+        cg.conditionArray[j] = 1 + nextCondition++ % MAX_CONDITIONS;
+      }
+      actionGroup &ag = actionGroups[r];
+      ag.status = true;
+      for (uint8_t j = 0; j < groupSize && j < MAX_ACTIONS_PER_GROUP; j++) {
+        ag.actionArray[j] = 1 + nextAction++ % MAX_ACTIONS;
+      }
+      ru.conditionSourceId = cg.num;
+      ru.actionTargetId = ag.num;
+    } else {
+      ru.conditionSourceId = 1 + nextCondition++ % MAX_CONDITIONS;
+      ru.actionTargetId = 1 + nextAction++ % MAX_ACTIONS;
+    }
+  }
+}
@@ -0,0 +1,24 @@
+#ifndef SIM_SCAN_H
+#define SIM_SCAN_H
+
+#include <Arduino.h>
+
+#include "dataStructure.h"
+
+// Host side of the firmware scan cycle. The scan steps themselves are the
+// firmware's (src/scanCycle.h); edges of the virtual inputs go through the
+// same interrupt capture, so flags behave as on the device. Image swaps,
+// scan statistics and the period timing of the scan task are not simulated.
+
+// Pins, input capture and schedules for the loaded config (call after each
+// load, then resetRuleEngine())
+void simConfigurePins();
+// One scan at the simulated time: latch, schedules, queued writes, rules
+// (only if deviceSettings.run), commit, process image
+void simScanCycle();
+
+// Fills the global configuration arrays with a generated config using
+// 'ruleCount' rules whose condition/action groups hold 'groupSize' members.
+void buildSyntheticConfig(uint8_t ruleCount, uint8_t groupSize);
+
+#endif  // SIM_SCAN_H
@@ -0,0 +1,196 @@
+#include "analogInput.h"
+
+#include <driver/adc.h>
+
+#include <atomic>
+
+#include "configJson.h"
+
+#define ADC1_CHANNELS 8
+#define ANALOG_FILTER_FRACTION 4  // Filter state keeps 4 fractional bits
+
+analogInputStatistics analogInputStats;
+
+static TaskHandle_t analogTask = NULL;
+static std::atomic<uint8_t> requestedMask(0);  // Written by the scan task
+static std::atomic<uint8_t> runningMask(0);    // Channels being sampled
+static std::atomic<uint8_t> readyMask(0);      // Channels with a reading
+static std::atomic<uint16_t> channelValue[ADC1_CHANNELS];
+
+// ADC1 channel of a GPIO, -1 if the pin has none
+static int8_t adc1Channel(uint8_t gpio) {
+  switch (gpio) {
+    case 36: return 0;
+    case 37: return 1;
+    case 38: return 2;
+    case 39: return 3;
+    case 32: return 4;
+    case 33: return 5;
+    case 34: return 6;
+    case 35: return 7;
+    default: return -1;
+  }
+}
+
+// --- Acquisition Task (owns the ADC driver) ---
+static void stopConversions() {
+  if (runningMask.load(std::memory_order_relaxed) == 0) return;
+  adc_digi_stop();
+  adc_digi_deinit();
+  runningMask.store(0, std::memory_order_release);
+}
+
+static bool startConversions(uint8_t mask) {
+  adc_digi_init_config_t init = {};
+  init.max_store_buf_size = ANALOG_DMA_FRAME_SIZE * 4;
+  init.conv_num_each_intr = ANALOG_DMA_FRAME_SIZE;
+  init.adc1_chan_mask = mask;
+  init.adc2_chan_mask = 0;
+  if (adc_digi_initialize(&init) != ESP_OK) return false;
+
+  adc_digi_pattern_config_t pattern[ADC1_CHANNELS] = {};
+  uint8_t count = 0;
+  for (uint8_t ch = 0; ch < ADC1_CHANNELS; ch++) {
+    if (!(mask & (1 << ch))) continue;
+    pattern[count].atten = ADC_ATTEN_DB_11;  // Same range as analogRead()
+    pattern[count].channel = ch;
+    pattern[count].unit = 0;  // ADC1
+    pattern[count].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    count++;
+  }
+  adc_digi_configuration_t config = {};
+  config.conv_limit_en = 1;  // Required on the ESP32
+  config.conv_limit_num = 250;
+  config.pattern_num = count;
+  config.adc_pattern = pattern;
+  config.sample_freq_hz = ANALOG_SAMPLE_RATE_HZ;
+  config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+  if (adc_digi_controller_configure(&config) != ESP_OK ||
+      adc_digi_start() != ESP_OK) {
+    adc_digi_deinit();
+    return false;
+  }
+  runningMask.store(mask, std::memory_order_release);
+  analogInputStats.channels = count;
+  return true;
+}
+
+static void analogTaskFunction(void *pvParameters) {
+  uint8_t frame[ANALOG_DMA_FRAME_SIZE];
+  uint32_t sum[ADC1_CHANNELS];
+  uint8_t samples[ADC1_CHANNELS];
+  int32_t filtered[ADC1_CHANNELS];  // Fixed point, ANALOG_FILTER_FRACTION
+
+  for (;;) {
+    uint8_t mask = requestedMask.load(std::memory_order_acquire);
+    if (mask != runningMask.load(std::memory_order_relaxed)) {
+      stopConversions();
+      readyMask.store(0, std::memory_order_release);
+      memset(sum, 0, sizeof(sum));
+      memset(samples, 0, sizeof(samples));
+      if (mask != 0 && !startConversions(mask)) {
+        Serial.println("Analog inputs: ADC DMA start failed");
+        analogInputStats.startFailures++;
+        analogInputStats.channels = 0;
+        // The channels fall back to analogRead() until the next channel set,
+        // unless the scan task has requested one meanwhile
+        requestedMask.compare_exchange_strong(mask, 0,
+                                              std::memory_order_acq_rel);
+      }
+    }
+    if (runningMask.load(std::memory_order_relaxed) == 0) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);  // Until the set changes
+      continue;
+    }
+
+    uint32_t length = 0;
+    esp_err_t result =
+        adc_digi_read_bytes(frame, sizeof(frame), &length, ADC_MAX_DELAY);
+    if (result == ESP_ERR_INVALID_STATE) {
+      analogInputStats.overflows++;  // Data returned, older frames dropped
+    } else if (result != ESP_OK) {
+      continue;
+    }
+
+    uint8_t shift = defaultConfig.analogFilter;
+    if (shift > MAX_ANALOG_FILTER) shift = MAX_ANALOG_FILTER;
+    for (uint32_t i = 0; i + 1 < length; i += 2) {
+      const adc_digi_output_data_t *sample =
+          (const adc_digi_output_data_t *)&frame[i];
+      uint8_t ch = sample->type1.channel;
+      if (ch >= ADC1_CHANNELS) continue;
+      analogInputStats.samples++;
+      sum[ch] += sample->type1.data;
+      if (++samples[ch] < ANALOG_OVERSAMPLE) continue;
+
+      int32_t average = (sum[ch] << ANALOG_FILTER_FRACTION) / samples[ch];
+      sum[ch] = 0;
+      samples[ch] = 0;
+      uint8_t bit = 1 << ch;
+      if (!(readyMask.load(std::memory_order_relaxed) & bit)) {
+        filtered[ch] = average;  // Start from the first average, not zero
+      } else {
+        filtered[ch] += (average - filtered[ch]) >> shift;
+      }
+      channelValue[ch].store(
+          (filtered[ch] + (1 << (ANALOG_FILTER_FRACTION - 1))) >>
+              ANALOG_FILTER_FRACTION,
+          std::memory_order_relaxed);
+      readyMask.fetch_or(bit, std::memory_order_release);
+      analogInputStats.steps++;
+    }
+  }
+}
+// --- End Acquisition Task ---
+
+static uint8_t requestChannels() {
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    const IOVariable &io = IOVariables[i];
+    if (!io.status || io.type != AnalogInput) continue;
+    int8_t ch = adc1Channel(io.gpio);
+    if (ch >= 0) mask |= 1 << ch;
+  }
+  if (mask == requestedMask.load(std::memory_order_relaxed) &&
+      analogTask != NULL) {
+    return mask;
+  }
+  requestedMask.store(mask, std::memory_order_release);
+  if (analogTask == NULL) {
+    xTaskCreatePinnedToCore(analogTaskFunction, "analogTask",
+                            ANALOG_TASK_STACK, NULL, ANALOG_TASK_PRIORITY,
+                            &analogTask, ANALOG_TASK_CORE);
+  } else {
+    xTaskNotifyGive(analogTask);
+  }
+  return mask;
+}
+
+void updateAnalogInputs() { requestChannels(); }
+
+void startAnalogInputs() {
+  uint8_t mask = requestChannels();
+  for (uint8_t waited = 0; waited < ANALOG_START_WAIT_MS; waited++) {
+    if ((readyMask.load(std::memory_order_acquire) & mask) == mask &&
+        runningMask.load(std::memory_order_relaxed) == mask) {
+      break;
+    }
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+}
+
+analogReading readAnalogInput(uint8_t gpio, int32_t &raw) {
+  int8_t ch = adc1Channel(gpio);
+  if (ch < 0) return ANALOG_NOT_SAMPLED;
+  uint8_t bit = 1 << ch;
+  bool running = runningMask.load(std::memory_order_relaxed) & bit;
+  if (!running && !(requestedMask.load(std::memory_order_acquire) & bit)) {
+    return ANALOG_NOT_SAMPLED;  // Not requested, or the DMA start failed
+  }
+  if (!running || !(readyMask.load(std::memory_order_acquire) & bit)) {
+    return ANALOG_PENDING;  // Requested, no filter step yet
+  }
+  raw = channelValue[ch].load(std::memory_order_relaxed);
+  return ANALOG_READY;
+}
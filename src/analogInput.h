@@ -0,0 +1,57 @@
+#ifndef ANALOG_INPUT_H
+#define ANALOG_INPUT_H
+
+#include <Arduino.h>
+
+#include "dataStructure.h"
+
+// Continuous acquisition of AnalogInputs on ADC1 pins (GPIO 32-39). The ADC
+// digital controller samples every used channel in turn and DMA delivers the
+// results to a task on core 0, which averages ANALOG_OVERSAMPLE samples per
+// channel and smooths the averages with a first-order IIR filter:
+//   filtered += (average - filtered) / 2^analogFilter
+// The scan task only picks up the latest filtered reading, so the input
+// latch never waits on the ADC. AnalogInputs on other pins keep using
+// analogRead() (ADC2 cannot run in DMA mode or alongside WiFi).
+
+#define ANALOG_SAMPLE_RATE_HZ 20000  // All channels together (ESP32 minimum)
+#define ANALOG_OVERSAMPLE 64         // Samples averaged per filter step
+#define ANALOG_DMA_FRAME_SIZE 256    // Bytes per DMA frame, 2 per sample
+#define ANALOG_START_WAIT_MS 50      // First readings before the first scan
+
+#define DEFAULT_ANALOG_FILTER 3  // IIR shift, 0 = plain oversampled average
+#define MAX_ANALOG_FILTER 6
+
+#define ANALOG_TASK_CORE 0
+#define ANALOG_TASK_PRIORITY 2  // Above the network and persistence tasks
+#define ANALOG_TASK_STACK 3072
+
+enum analogReading {
+  ANALOG_NOT_SAMPLED,  // Not an ADC1 pin or DMA failed: use analogRead()
+  ANALOG_PENDING,      // Channel (re)starting: keep the previous value
+  ANALOG_READY
+};
+
+struct analogInputStatistics {
+  uint32_t samples;        // Conversions received
+  uint32_t steps;          // Filter steps (oversampled averages) published
+  uint32_t overflows;      // DMA frames lost because the task fell behind
+  uint32_t startFailures;  // Channel sets the ADC DMA could not start
+  uint8_t channels;        // ADC1 channels being sampled
+};
+
+extern analogInputStatistics analogInputStats;
+
+// Starts sampling the ADC1 pins of the enabled AnalogInputs and waits up to
+// ANALOG_START_WAIT_MS for their first readings (scan task, before the first
+// scan)
+void startAnalogInputs();
+
+// Follows the channel set of a new IOVariables image without waiting; new
+// channels read ANALOG_PENDING until their first filter step (scan task)
+void updateAnalogInputs();
+
+// Latest filtered 12-bit reading of 'gpio' (scan task, non-blocking)
+analogReading readAnalogInput(uint8_t gpio, int32_t &raw);
+
+#endif  // ANALOG_INPUT_H
@@ -0,0 +1,103 @@
+#ifndef CAPACITY_PROFILE_H
+#define CAPACITY_PROFILE_H
+
+#include <stdint.h>
+
+// Build-time capacity of the data model. A build picks one profile with
+// -D CAPACITY_PROFILE=CAPACITY_SMALL / CAPACITY_LARGE (see platformio.ini);
+// any single limit can still be overridden with its own -D flag. Every
+// configuration array, the compiled rule program and the binary config are
+// sized from these limits, so RAM use follows the profile.
+
+#define CAPACITY_SMALL 0     // Minimal RAM: a handful of rules
+#define CAPACITY_STANDARD 1  // Default firmware build
+#define CAPACITY_LARGE 2     // 100+ rules; logic IDs become 16-bit
+
+#ifndef CAPACITY_PROFILE
+#define CAPACITY_PROFILE CAPACITY_STANDARD
+#endif
+
+#if CAPACITY_PROFILE == CAPACITY_SMALL
+#define PROFILE_SOFTIO 4
+#define PROFILE_TIMERS 4
+#define PROFILE_SCHEDULES 2
+#define PROFILE_CONDITIONS 24
+#define PROFILE_CONDITION_GROUPS 8
+#define PROFILE_ACTIONS 24
+#define PROFILE_ACTION_GROUPS 8
+#define PROFILE_RULES 12
+#define PROFILE_PER_GROUP 6
+#elif CAPACITY_PROFILE == CAPACITY_STANDARD
+#define PROFILE_SOFTIO 5
+#define PROFILE_TIMERS 5
+#define PROFILE_SCHEDULES 5
+#define PROFILE_CONDITIONS 50
+#define PROFILE_CONDITION_GROUPS 20
+#define PROFILE_ACTIONS 50
+#define PROFILE_ACTION_GROUPS 20
+#define PROFILE_RULES 20
+#define PROFILE_PER_GROUP 10
+#elif CAPACITY_PROFILE == CAPACITY_LARGE
+#define PROFILE_SOFTIO 16
+#define PROFILE_TIMERS 16
+#define PROFILE_SCHEDULES 8
+#define PROFILE_CONDITIONS 320
+#define PROFILE_CONDITION_GROUPS 96
+#define PROFILE_ACTIONS 320
+#define PROFILE_ACTION_GROUPS 96
+#define PROFILE_RULES 128
+#define PROFILE_PER_GROUP 10
+#else
+#error "Unknown CAPACITY_PROFILE"
+#endif
+
+#ifndef MAX_SOFTIO
+#define MAX_SOFTIO PROFILE_SOFTIO
+#endif
+#ifndef MAX_TIMERS
+#define MAX_TIMERS PROFILE_TIMERS
+#endif
+#ifndef MAX_SCHEDULES
+#define MAX_SCHEDULES PROFILE_SCHEDULES
+#endif
+#ifndef MAX_CONDITIONS
+#define MAX_CONDITIONS PROFILE_CONDITIONS
+#endif
+#ifndef MAX_CONDITION_GROUPS
+#define MAX_CONDITION_GROUPS PROFILE_CONDITION_GROUPS
+#endif
+#ifndef MAX_ACTIONS
+#define MAX_ACTIONS PROFILE_ACTIONS
+#endif
+#ifndef MAX_ACTION_GROUPS
+#define MAX_ACTION_GROUPS PROFILE_ACTION_GROUPS
+#endif
+#ifndef MAX_RULES
+#define MAX_RULES PROFILE_RULES
+#endif
+#ifndef MAX_CONDITIONS_PER_GROUP
+#define MAX_CONDITIONS_PER_GROUP PROFILE_PER_GROUP
+#endif
+#ifndef MAX_ACTIONS_PER_GROUP
+#define MAX_ACTIONS_PER_GROUP PROFILE_PER_GROUP
+#endif
+
+// IDs of conditions, actions, groups and rules, and the indexes the rule
+// compiler derives from them. 0 means "unused" and the all-ones value marks
+// an entry that was not compiled, so an 8-bit ID allows up to 254 entries.
+#if MAX_CONDITIONS > 254 || MAX_ACTIONS > 254 || MAX_CONDITION_GROUPS > 254 || \
+    MAX_ACTION_GROUPS > 254 || MAX_RULES > 254
+typedef uint16_t logicId;
+#else
+typedef uint8_t logicId;
+#endif
+
+#define LOGIC_ID_NONE ((logicId)~0)
+
+// Rule numbers travel as 8 bits in event records; group members are
+// counted with 8-bit loop indexes
+static_assert(MAX_RULES <= 254, "Rule numbers must fit eventRecord::ruleNum");
+static_assert(MAX_CONDITIONS_PER_GROUP <= 254 && MAX_ACTIONS_PER_GROUP <= 254,
+              "Group member lists are indexed with uint8_t");
+
+#endif  // CAPACITY_PROFILE_H
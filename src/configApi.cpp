@@ -0,0 +1,176 @@
+#include "configApi.h"
+
+#include "configBinary.h"
+#include "configPortal.h"
+#include "processImage.h"
+
+#define API_PREFIX "/api/"
+
+struct apiResource {
+  const char *section;  // Key of the section in the config document
+  configSectionId binarySection;
+  bool hasElements;  // Edited one element at a time
+};
+
+static const apiResource resources[] = {
+    {"deviceSettings", CONFIG_SECTION_DEVICE, false},
+    {"ioVariables", CONFIG_SECTION_IO_VARIABLES, true},
+    {"conditions", CONFIG_SECTION_CONDITIONS, true},
+    {"conditionGroups", CONFIG_SECTION_CONDITION_GROUPS, true},
+    {"actions", CONFIG_SECTION_ACTIONS, true},
+    {"actionGroups", CONFIG_SECTION_ACTION_GROUPS, true},
+    {"rules", CONFIG_SECTION_RULES, true},
+    {"ruleSequence", CONFIG_SECTION_RULE_SEQUENCE, false},
+    {"schedules", CONFIG_SECTION_SCHEDULES, true},
+};
+
+struct apiTarget {
+  const apiResource *resource;
+  uint16_t index;  // Array index, CONFIG_NO_INDEX for a whole section
+};
+
+// Array index of the element with ID 'id' (IO slot for ioVariables)
+static int32_t findElement(configSectionId section, uint32_t id) {
+  if (section == CONFIG_SECTION_IO_VARIABLES) {
+    return id < MAX_IO_VARIABLES ? (int32_t)id : -1;
+  }
+  if (id == 0) return -1;  // 0 marks unused entries
+  switch (section) {
+    case CONFIG_SECTION_CONDITIONS:
+      for (logicId i = 0; i < MAX_CONDITIONS; i++) {
+        if (conditions[i].conNum == id) return i;
+      }
+      break;
+    case CONFIG_SECTION_CONDITION_GROUPS:
+      for (logicId i = 0; i < MAX_CONDITION_GROUPS; i++) {
+        if (conditionGroups[i].num == id) return i;
+      }
+      break;
+    case CONFIG_SECTION_ACTIONS:
+      for (logicId i = 0; i < MAX_ACTIONS; i++) {
+        if (actions[i].actNum == id) return i;
+      }
+      break;
+    case CONFIG_SECTION_ACTION_GROUPS:
+      for (logicId i = 0; i < MAX_ACTION_GROUPS; i++) {
+        if (actionGroups[i].num == id) return i;
+      }
+      break;
+    case CONFIG_SECTION_RULES:
+      for (logicId i = 0; i < MAX_RULES; i++) {
+        if (rules[i].num == id) return i;
+      }
+      break;
+    case CONFIG_SECTION_SCHEDULES:
+      for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        if (schedules[i].num == id) return i;
+      }
+      break;
+    default:
+      break;
+  }
+  return -1;
+}
+
+// "/api/<section>[/<id>]" -> resource and array index
+static bool resolveTarget(const String &url, apiTarget &target) {
+  const char *path = url.c_str();
+  if (strncmp(path, API_PREFIX, strlen(API_PREFIX)) != 0) return false;
+  path += strlen(API_PREFIX);
+  const char *slash = strchr(path, '/');
+  size_t nameLength = slash ? (size_t)(slash - path) : strlen(path);
+
+  for (const apiResource &resource : resources) {
+    if (strlen(resource.section) != nameLength ||
+        strncmp(resource.section, path, nameLength) != 0) {
+      continue;
+    }
+    target.resource = &resource;
+    target.index = CONFIG_NO_INDEX;
+    if (!resource.hasElements) return slash == nullptr;
+    if (slash == nullptr || !isdigit((uint8_t)slash[1])) return false;
+    char *end;
+    uint32_t id = strtoul(slash + 1, &end, 10);
+    if (*end != '\0') return false;
+    int32_t index = findElement(resource.binarySection, id);
+    if (index < 0) return false;
+    target.index = index;
+    return true;
+  }
+  return false;
+}
+
+// --- Runtime Writes ---
+// Form field or query parameter
+static const AsyncWebParameter *findParam(AsyncWebServerRequest *request,
+                                          const char *name) {
+  if (request->hasParam(name, true)) return request->getParam(name, true);
+  if (request->hasParam(name)) return request->getParam(name);
+  return nullptr;
+}
+
+static void setupIOCommands(AsyncWebServer &server) {
+  server.on(IO_COMMAND_PATH, HTTP_POST, [](AsyncWebServerRequest *request) {
+    static const char *const fieldNames[] = {"state", "value", "flag"};
+    const AsyncWebParameter *slotParam = findParam(request, "slot");
+    long slot = slotParam ? slotParam->value().toInt() : -1;
+    if (slot < 0 || slot >= MAX_IO_VARIABLES) {
+      request->send(400, "text/plain", "Invalid slot");
+      return;
+    }
+    for (uint8_t f = 0; f < 3; f++) {
+      const AsyncWebParameter *param = findParam(request, fieldNames[f]);
+      if (param == nullptr) continue;
+      ioCommand command = {(uint8_t)slot, (ioCommandField)f,
+                           (int32_t)param->value().toInt()};
+      if (!isWritableField(IOVariables[slot], command.field)) {
+        request->send(400, "text/plain", "Field not writable");
+      } else if (!queueIOCommand(command)) {
+        request->send(503, "text/plain", "Command queue full");
+      } else {
+        request->send(202, "text/plain", "Queued");
+      }
+      return;
+    }
+    request->send(400, "text/plain", "Missing state, value or flag");
+  });
+}
+// --- End Runtime Writes ---
+
+void setupConfigApi(AsyncWebServer &server) {
+  setupIOCommands(server);
+
+  // Matches every URL below /api/. The body has been parsed by the time the
+  // request handler runs.
+  server.on(
+      "/api", HTTP_PUT | HTTP_PATCH,
+      [](AsyncWebServerRequest *request) {
+        apiTarget target;
+        if (!resolveTarget(request->url(), target)) {
+          request->send(404, "text/plain", "No such configuration entity");
+          return;
+        }
+        if (heldConfigParser(request) == nullptr) {
+          if (request->contentLength() == 0) {
+            request->send(400, "text/plain", "Missing JSON body");
+          } else {
+            request->send(409, "text/plain", "Superseded by a newer upload");
+          }
+          return;
+        }
+        applyParsedConfig(request, target.resource->binarySection);
+      },
+      NULL,
+      [](AsyncWebServerRequest *request, uint8_t *data, size_t len,
+         size_t index, size_t total) {
+        if (index == 0) {
+          apiTarget target;
+          if (!resolveTarget(request->url(), target)) return;
+          claimConfigParser(request).beginPart(
+              target.resource->section, target.index,
+              request->method() == HTTP_PUT);
+        }
+        configJsonParser *parser = heldConfigParser(request);
+        if (parser != nullptr) parser->feed((const char *)data, len);
+      });
+}
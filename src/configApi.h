@@ -0,0 +1,34 @@
+#ifndef CONFIG_API_H
+#define CONFIG_API_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+// Edits of a single configuration entity, without a full /config upload:
+//
+//   PUT|PATCH /api/rules/{n}            rule with "n" = {n}
+//   PUT|PATCH /api/conditions/{n}       condition with "cn" = {n}
+//   PUT|PATCH /api/actions/{n}          action with "an" = {n}
+//   PUT|PATCH /api/conditionGroups/{n}  PUT|PATCH /api/actionGroups/{n}
+//   PUT|PATCH /api/schedules/{n}        by "n"
+//   PUT|PATCH /api/ioVariables/{slot}   by position in GET /config
+//   PUT /api/ruleSequence               [3,1,2,...]
+//   PATCH /api/deviceSettings           {"run":true,...}
+//
+// Bodies use the keys of the config document. PATCH changes only the fields
+// present; PUT resets what a full upload resets (group members, rule
+// sources and targets, rule order). The edit is validated like an upload,
+// applied between two scans (edge memory of unchanged rules carries over)
+// and only the edited section of config.bin is rewritten.
+//
+// Runtime values are written through the scan's command queue
+// (processImage.h) and are not saved:
+//
+//   POST /io   slot=<n> and one of state=0|1, value=<int>, flag=0|1
+//              202 queued, 400 slot or field not writable, 503 queue full
+
+#define IO_COMMAND_PATH "/io"
+
+void setupConfigApi(AsyncWebServer &server);
+
+#endif  // CONFIG_API_H
@@ -0,0 +1,142 @@
+#include "configBinary.h"
+
+#include <esp_rom_crc.h>
+
+struct configSection {
+  void *data;
+  size_t size;
+};
+
+// Payload layout, in file order
+static void collectSections(configSection *sections) {
+  sections[CONFIG_SECTION_DEVICE] = {&defaultConfig, sizeof(defaultConfig)};
+  sections[CONFIG_SECTION_IO_VARIABLES] = {
+      IOVariables, sizeof(IOVariable) * MAX_IO_VARIABLES};
+  sections[CONFIG_SECTION_CONDITIONS] = {conditions, sizeof(conditions)};
+  sections[CONFIG_SECTION_CONDITION_GROUPS] = {conditionGroups,
+                                               sizeof(conditionGroups)};
+  sections[CONFIG_SECTION_ACTIONS] = {actions, sizeof(actions)};
+  sections[CONFIG_SECTION_ACTION_GROUPS] = {actionGroups,
+                                            sizeof(actionGroups)};
+  sections[CONFIG_SECTION_RULES] = {rules, sizeof(rules)};
+  sections[CONFIG_SECTION_RULE_SEQUENCE] = {ruleSequence,
+                                            sizeof(ruleSequence)};
+  sections[CONFIG_SECTION_SCHEDULES] = {schedules, sizeof(schedules)};
+}
+
+static uint32_t payloadSizeOf(const configSection *sections) {
+  uint32_t payloadSize = 0;
+  for (uint8_t i = 0; i < CONFIG_SECTIONS; i++) {
+    payloadSize += sections[i].size;
+  }
+  return payloadSize;
+}
+
+static uint32_t sectionCrc(const configSection &section) {
+  return esp_rom_crc32_le(0, (const uint8_t *)section.data, section.size);
+}
+
+static void fillHeader(configBinaryHeader &header, uint32_t payloadSize,
+                       uint32_t jsonSize) {
+  memset(&header, 0, sizeof(header));
+  header.magic = CONFIG_BINARY_MAGIC;
+  header.version = CONFIG_BINARY_VERSION;
+  header.headerSize = sizeof(header);
+  header.capacityProfile = CAPACITY_PROFILE;
+  header.logicIdSize = sizeof(logicId);
+  header.maxIOVariables = MAX_IO_VARIABLES;
+  header.maxConditions = MAX_CONDITIONS;
+  header.maxConditionGroups = MAX_CONDITION_GROUPS;
+  header.maxActions = MAX_ACTIONS;
+  header.maxActionGroups = MAX_ACTION_GROUPS;
+  header.maxRules = MAX_RULES;
+  header.maxConditionsPerGroup = MAX_CONDITIONS_PER_GROUP;
+  header.maxActionsPerGroup = MAX_ACTIONS_PER_GROUP;
+  header.payloadSize = payloadSize;
+  header.jsonSize = jsonSize;
+}
+
+// True if 'header' describes a snapshot of this build, whatever its contents
+static bool headerMatches(const configBinaryHeader &header,
+                          uint32_t payloadSize, uint32_t jsonSize) {
+  configBinaryHeader expected;
+  fillHeader(expected, payloadSize, jsonSize);
+  // The CRCs are the only fields not predictable
+  memcpy(expected.sectionCrc, header.sectionCrc, sizeof(expected.sectionCrc));
+  return memcmp(&header, &expected, sizeof(header)) == 0;
+}
+
+bool writeConfigBinary(Print &out, uint32_t jsonSize) {
+  configSection sections[CONFIG_SECTIONS];
+  collectSections(sections);
+  configBinaryHeader header;
+  fillHeader(header, payloadSizeOf(sections), jsonSize);
+  for (uint8_t i = 0; i < CONFIG_SECTIONS; i++) {
+    header.sectionCrc[i] = sectionCrc(sections[i]);
+  }
+  if (out.write((const uint8_t *)&header, sizeof(header)) != sizeof(header)) {
+    return false;
+  }
+  for (uint8_t i = 0; i < CONFIG_SECTIONS; i++) {
+    if (out.write((const uint8_t *)sections[i].data, sections[i].size) !=
+        sections[i].size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool readConfigBinary(Stream &in, uint32_t jsonSize) {
+  configSection sections[CONFIG_SECTIONS];
+  collectSections(sections);
+  configBinaryHeader header;
+  if (in.readBytes((char *)&header, sizeof(header)) != sizeof(header)) {
+    return false;
+  }
+  if (!headerMatches(header, payloadSizeOf(sections), jsonSize)) return false;
+
+  for (uint8_t i = 0; i < CONFIG_SECTIONS; i++) {
+    if (in.readBytes((char *)sections[i].data, sections[i].size) !=
+            sections[i].size ||
+        sectionCrc(sections[i]) != header.sectionCrc[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool patchConfigBinary(File &file, configSectionId section,
+                       uint32_t jsonSize) {
+  configSection sections[CONFIG_SECTIONS];
+  collectSections(sections);
+  configBinaryHeader header;
+  if (!file.seek(0) ||
+      file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+      !headerMatches(header, payloadSizeOf(sections), header.jsonSize)) {
+    return false;
+  }
+
+  uint32_t offset = sizeof(header);
+  for (uint8_t i = 0; i < section; i++) {
+    offset += sections[i].size;
+  }
+  const configSection &patched = sections[section];
+  if (!file.seek(offset) ||
+      file.write((const uint8_t *)patched.data, patched.size) !=
+          patched.size) {
+    return false;
+  }
+  // A torn write leaves a CRC mismatch, and the boot falls back to the JSON
+  header.sectionCrc[section] = sectionCrc(patched);
+  header.jsonSize = jsonSize;
+  return file.seek(0) &&
+         file.write((const uint8_t *)&header, sizeof(header)) ==
+             sizeof(header);
+}
+
+bool markConfigBinaryStale(File &file) {
+  uint32_t jsonSize = 0;  // A saved config.json is never empty
+  return file.seek(offsetof(configBinaryHeader, jsonSize)) &&
+         file.write((const uint8_t *)&jsonSize, sizeof(jsonSize)) ==
+             sizeof(jsonSize);
+}
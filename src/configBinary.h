@@ -0,0 +1,73 @@
+#ifndef CONFIG_BINARY_H
+#define CONFIG_BINARY_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "configJson.h"
+#include "dataStructure.h"
+
+// Binary snapshot of the configuration: a header followed by deviceConfig and
+// the configuration arrays exactly as they sit in RAM. Loading is a CRC check
+// plus straight reads into the arrays. config.json stays the portable copy
+// and is used whenever the snapshot is missing, stale or from another build.
+// Each section has its own CRC, so a single edited section can be rewritten
+// in place without reading the rest of the file back.
+
+#define CONFIG_BINARY_MAGIC 0x47464341UL  // "ACFG"
+#define CONFIG_BINARY_VERSION 4           // Bump when a packed struct changes
+
+// Payload sections, in file order
+enum configSectionId : uint8_t {
+  CONFIG_SECTION_DEVICE,
+  CONFIG_SECTION_IO_VARIABLES,
+  CONFIG_SECTION_CONDITIONS,
+  CONFIG_SECTION_CONDITION_GROUPS,
+  CONFIG_SECTION_ACTIONS,
+  CONFIG_SECTION_ACTION_GROUPS,
+  CONFIG_SECTION_RULES,
+  CONFIG_SECTION_RULE_SEQUENCE,
+  CONFIG_SECTION_SCHEDULES,
+  CONFIG_SECTIONS
+};
+
+struct configBinaryHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t headerSize;
+  // Capacity profile the payload was written with; any difference means
+  // another layout
+  uint8_t capacityProfile;
+  uint8_t logicIdSize;  // sizeof(logicId)
+  uint16_t maxIOVariables;
+  uint16_t maxConditions;
+  uint16_t maxConditionGroups;
+  uint16_t maxActions;
+  uint16_t maxActionGroups;
+  uint16_t maxRules;
+  uint16_t maxConditionsPerGroup;
+  uint16_t maxActionsPerGroup;
+  uint32_t payloadSize;
+  uint32_t jsonSize;  // Size of the config.json saved alongside, to spot
+                      // a JSON file replaced behind the snapshot's back
+  uint32_t sectionCrc[CONFIG_SECTIONS];  // CRC32 of each payload section
+};
+
+// Writes header + payload from the live configuration
+bool writeConfigBinary(Print &out, uint32_t jsonSize);
+
+// Reads a snapshot straight into the live configuration. Returns false on
+// any mismatch; the arrays may then be partly overwritten and must be
+// reloaded from another source.
+bool readConfigBinary(Stream &in, uint32_t jsonSize);
+
+// Rewrites one section of an existing snapshot from the live configuration,
+// then its header. Returns false if the file is not a snapshot of this
+// build; the caller then writes a full one.
+bool patchConfigBinary(File &file, configSectionId section, uint32_t jsonSize);
+
+// Clears the header's jsonSize so the snapshot matches no config.json until
+// patchConfigBinary() writes the new size
+bool markConfigBinaryStale(File &file);
+
+#endif  // CONFIG_BINARY_H
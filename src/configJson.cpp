@@ -0,0 +1,869 @@
+#include "configJson.h"
+
+#include <stdarg.h>
+
+#include "analogInput.h"
+#include "persistence.h"
+#include "processImage.h"
+#include "scanEngine.h"
+#include "timeSync.h"
+
+deviceConfig defaultConfig = {"advancedtimer", "12345678", "AdvancedTimer",
+                              false, DEFAULT_SCAN_PERIOD_MS,
+                              DEFAULT_PERSIST_INTERVAL_S,
+                              DEFAULT_ANALOG_FILTER, DEFAULT_NTP_SERVER,
+                              DEFAULT_TIME_ZONE};
+
+// --- Streaming Serializer ---
+enum streamSection {
+  STREAM_DEVICE,
+  STREAM_IO_VARIABLES,
+  STREAM_CONDITIONS,
+  STREAM_CONDITION_GROUPS,
+  STREAM_ACTIONS,
+  STREAM_ACTION_GROUPS,
+  STREAM_RULES,
+  STREAM_RULE_SEQUENCE,
+  STREAM_SCHEDULES,
+  STREAM_CLOSE,
+  STREAM_DONE
+};
+
+void configJsonStream::begin() {
+  section = STREAM_DEVICE;
+  index = 0;
+  pieceLength = 0;
+  piecePos = 0;
+  hasSnapshot = readProcessImage(snapshot);
+}
+
+// Before the first scan nothing else writes the live image
+processEntry configJsonStream::runtimeOf(uint8_t slot) {
+  if (hasSnapshot) return snapshot.io[slot];
+  const IOVariable &io = IOVariables[slot];
+  return {io.value, io.state, io.flag};
+}
+
+void configJsonStream::append(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(piece + pieceLength, sizeof(piece) - pieceLength, format,
+                    args);
+  va_end(args);
+  if (n <= 0) return;
+  size_t room = sizeof(piece) - 1 - pieceLength;  // Truncates, never overruns
+  pieceLength += ((size_t)n < room) ? n : room;
+}
+
+// Quoted and escaped the way ArduinoJson writes strings
+void configJsonStream::appendString(const char *text) {
+  append("\"");
+  for (const char *c = text; *c != '\0'; c++) {
+    switch (*c) {
+      case '"':
+        append("\\\"");
+        break;
+      case '\\':
+        append("\\\\");
+        break;
+      case '\n':
+        append("\\n");
+        break;
+      case '\r':
+        append("\\r");
+        break;
+      case '\t':
+        append("\\t");
+        break;
+      default:
+        if ((uint8_t)*c < 0x20) {
+          append("\\u%04x", (uint8_t)*c);
+        } else {
+          append("%c", *c);
+        }
+    }
+  }
+  append("\"");
+}
+
+// Writes the key and '[' before the first element, ',' between elements
+void configJsonStream::openElement(const char *key) {
+  if (index == 0) {
+    append(",\"%s\":[", key);
+  } else {
+    append(",");
+  }
+}
+
+// Closes the array after the last element and moves to the next section
+void configJsonStream::closeElement(uint16_t count) {
+  if (++index < count) return;
+  append("]");
+  section++;
+  index = 0;
+}
+
+// Renders the next piece of the document; false once everything is written
+bool configJsonStream::renderNext() {
+  pieceLength = 0;
+  piecePos = 0;
+  piece[0] = '\0';
+  switch (section) {
+    case STREAM_DEVICE:  // Split so each escaped string fits one piece
+      if (index == 0) {
+        append("{\"deviceSettings\":{\"SSID\":");
+        appendString(defaultConfig.SSID);
+      } else if (index == 1) {
+        append(",\"PASS\":");
+        appendString(defaultConfig.PASS);
+      } else if (index == 2) {
+        append(",\"DeviceName\":");
+        appendString(defaultConfig.DeviceName);
+      } else if (index == 3) {
+        append(",\"ntpServer\":");
+        appendString(defaultConfig.ntpServer);
+      } else {
+        append(",\"timeZone\":");
+        appendString(defaultConfig.timeZone);
+        append(",\"run\":%s,\"scanPeriod\":%u,\"persistInterval\":%u,"
+               "\"analogFilter\":%u}",
+               boolText(defaultConfig.run), defaultConfig.scanPeriodMs,
+               defaultConfig.persistIntervalS, defaultConfig.analogFilter);
+        section++;
+        index = 0;
+        break;
+      }
+      index++;
+      break;
+    case STREAM_IO_VARIABLES: {
+      const IOVariable &io = IOVariables[index];
+      processEntry runtime = runtimeOf(index);
+      openElement("ioVariables");
+      append("{\"n\":%u,\"t\":%d,\"g\":%u,\"m\":%d,\"nm\":", io.num, io.type,
+             io.gpio, io.mode);
+      appendString(io.name);
+      append(",\"st\":%s,\"v\":%ld,\"f\":%s,\"s\":%s}",
+             boolText(runtime.state), (long)runtime.value,
+             boolText(runtime.flag), boolText(io.status));
+      closeElement(MAX_IO_VARIABLES);
+      break;
+    }
+    case STREAM_CONDITIONS: {
+      const condition &cond = conditions[index];
+      openElement("conditions");
+      append("{\"cn\":%u,\"t\":%d,\"tn\":%u,\"cp\":%d,\"v\":%ld,\"s\":%s}",
+             cond.conNum, cond.Type, cond.targetNum, cond.comp,
+             (long)cond.value, boolText(cond.status));
+      closeElement(MAX_CONDITIONS);
+      break;
+    }
+    case STREAM_CONDITION_GROUPS: {
+      const conditionGroup &group = conditionGroups[index];
+      openElement("conditionGroups");
+      append("{\"n\":%u,\"ca\":[", group.num);
+      for (uint8_t j = 0; j < MAX_CONDITIONS_PER_GROUP; j++) {
+        append(j == 0 ? "%u" : ",%u", group.conditionArray[j]);
+      }
+      append("],\"l\":%d,\"s\":%s}", group.Logic, boolText(group.status));
+      closeElement(MAX_CONDITION_GROUPS);
+      break;
+    }
+    case STREAM_ACTIONS: {
+      const action &act = actions[index];
+      openElement("actions");
+      append("{\"an\":%u,\"t\":%d,\"tn\":%u,\"a\":%d,\"v\":%ld,\"s\":%s}",
+             act.actNum, act.Type, act.targetNum, act.action, (long)act.value,
+             boolText(act.status));
+      closeElement(MAX_ACTIONS);
+      break;
+    }
+    case STREAM_ACTION_GROUPS: {
+      const actionGroup &group = actionGroups[index];
+      openElement("actionGroups");
+      append("{\"n\":%u,\"ar\":[", group.num);
+      for (uint8_t j = 0; j < MAX_ACTIONS_PER_GROUP; j++) {
+        append(j == 0 ? "%u" : ",%u", group.actionArray[j]);
+      }
+      append("],\"s\":%s}", boolText(group.status));
+      closeElement(MAX_ACTION_GROUPS);
+      break;
+    }
+    case STREAM_RULES: {
+      const rule &ru = rules[index];
+      openElement("rules");
+      append("{\"n\":%u,\"cg\":%s,\"ci\":%u,\"ag\":%s,\"ai\":%u,\"s\":%s}",
+             ru.num, boolText(ru.useConditionGroup), ru.conditionSourceId,
+             boolText(ru.useActionGroup), ru.actionTargetId,
+             boolText(ru.status));
+      closeElement(MAX_RULES);
+      break;
+    }
+    case STREAM_RULE_SEQUENCE:
+      openElement("ruleSequence");
+      append("%u", ruleSequence[index]);
+      closeElement(MAX_RULES);
+      break;
+    case STREAM_SCHEDULES: {
+      const schedule &sch = schedules[index];
+      openElement("schedules");
+      append("{\"n\":%u,\"d\":%u,\"on\":%u,\"off\":%u}", sch.num, sch.days,
+             sch.onMinute, sch.offMinute);
+      closeElement(MAX_SCHEDULES);
+      break;
+    }
+    case STREAM_CLOSE:
+      append("}");
+      section++;
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+size_t configJsonStream::read(uint8_t *buffer, size_t maxLen) {
+  size_t written = 0;
+  while (written < maxLen) {
+    if (piecePos == pieceLength && !renderNext()) break;
+    size_t n = pieceLength - piecePos;
+    if (n > maxLen - written) n = maxLen - written;
+    memcpy(buffer + written, piece + piecePos, n);
+    piecePos += n;
+    written += n;
+  }
+  return written;
+}
+// --- End Streaming Serializer ---
+
+String generateJsonConfigString() {
+  configJsonStream stream;
+  String output;
+  uint8_t buffer[128];
+  size_t n;
+  while ((n = stream.read(buffer, sizeof(buffer))) > 0) {
+    output.concat((const char *)buffer, n);
+  }
+  return output;
+}
+
+// --- Streaming Parser ---
+enum parseState {
+  PARSE_VALUE,         // Expecting a value
+  PARSE_ARRAY_START,   // After '[': value or ']'
+  PARSE_OBJECT_START,  // After '{': key or '}'
+  PARSE_KEY,           // After ',' in an object
+  PARSE_COLON,
+  PARSE_STRING,
+  PARSE_ESCAPE,
+  PARSE_UNICODE,
+  PARSE_SCALAR,        // Number or true/false/null
+  PARSE_AFTER_VALUE,   // Expecting ',' or a closing bracket
+  PARSE_DONE,
+  PARSE_ERROR
+};
+
+// Staged copy of everything a config upload can change
+struct configStage {
+  deviceConfig device;
+  IOVariable ioVariables[MAX_IO_VARIABLES];
+  condition conditions[MAX_CONDITIONS];
+  conditionGroup conditionGroups[MAX_CONDITION_GROUPS];
+  action actions[MAX_ACTIONS];
+  actionGroup actionGroups[MAX_ACTION_GROUPS];
+  rule rules[MAX_RULES];
+  logicId ruleSequence[MAX_RULES];
+  schedule schedules[MAX_SCHEDULES];
+};
+
+static configStage stage;
+
+// Largest ID a rule source / target may hold, whichever kind it refers to
+#define MAX_SOURCE_ID                                    \
+  (MAX_CONDITIONS > MAX_CONDITION_GROUPS ? MAX_CONDITIONS \
+                                         : MAX_CONDITION_GROUPS)
+#define MAX_TARGET_ID \
+  (MAX_ACTIONS > MAX_ACTION_GROUPS ? MAX_ACTIONS : MAX_ACTION_GROUPS)
+
+static bool keyIs(const char *key, const char *name) {
+  return strcmp(key, name) == 0;
+}
+
+static bool isSpace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Assigns only when the JSON value has the expected kind, like 'json | field'
+template <typename T>
+static void assignIf(bool matches, T &field, int32_t value) {
+  if (matches) field = (T)value;
+}
+
+void configJsonParser::begin() {
+  state = PARSE_VALUE;
+  depth = 0;
+  baseDepth = 0;
+  replaceElements = true;
+  readingKey = false;
+  rootDone = false;
+  dropped = 0;
+  rejected = 0;
+  highSurrogate = 0;
+
+  // Missing fields keep their live values; device settings start blank
+  stage.device = defaultConfig;
+  stage.device.SSID[0] = '\0';
+  stage.device.PASS[0] = '\0';
+  stage.device.DeviceName[0] = '\0';
+  stage.device.run = false;
+  stage.device.scanPeriodMs = DEFAULT_SCAN_PERIOD_MS;
+  stage.device.persistIntervalS = DEFAULT_PERSIST_INTERVAL_S;
+  stage.device.analogFilter = DEFAULT_ANALOG_FILTER;
+  strlcpy(stage.device.ntpServer, DEFAULT_NTP_SERVER,
+          sizeof(stage.device.ntpServer));
+  strlcpy(stage.device.timeZone, DEFAULT_TIME_ZONE,
+          sizeof(stage.device.timeZone));
+  memcpy(stage.ioVariables, IOVariables, sizeof(stage.ioVariables));
+  memcpy(stage.conditions, conditions, sizeof(stage.conditions));
+  memcpy(stage.conditionGroups, conditionGroups,
+         sizeof(stage.conditionGroups));
+  memcpy(stage.actions, actions, sizeof(stage.actions));
+  memcpy(stage.actionGroups, actionGroups, sizeof(stage.actionGroups));
+  memcpy(stage.rules, rules, sizeof(stage.rules));
+  memcpy(stage.schedules, schedules, sizeof(stage.schedules));
+  for (logicId i = 0; i < MAX_RULES; i++) {
+    stage.ruleSequence[i] = i + 1;
+  }
+}
+
+void configJsonParser::beginPart(const char *section, uint16_t index,
+                                 bool replace) {
+  begin();
+  stage.device = defaultConfig;
+  if (!keyIs(section, "ruleSequence") || !replace) {
+    memcpy(stage.ruleSequence, ruleSequence, sizeof(stage.ruleSequence));
+  }
+  replaceElements = replace;
+  // As if the parser had just read '{"section":' (and '[' plus 'index'
+  // elements for an array element)
+  frames[0].isArray = false;
+  frames[0].index = 0;
+  strlcpy(frames[0].key, section, sizeof(frames[0].key));
+  depth = 1;
+  if (index != CONFIG_NO_INDEX) {
+    frames[1].isArray = true;
+    frames[1].index = index;
+    frames[1].key[0] = '\0';
+    depth = 2;
+  }
+  baseDepth = depth;
+}
+
+bool configJsonParser::feed(const char *data, size_t len) {
+  for (size_t i = 0; i < len && state != PARSE_ERROR; i++) {
+    if (!consume(data[i])) state = PARSE_ERROR;
+  }
+  return state != PARSE_ERROR;
+}
+
+bool configJsonParser::finish() {
+  if (state == PARSE_SCALAR && !endScalar()) state = PARSE_ERROR;
+  return state == PARSE_DONE && rootDone;
+}
+
+void configJsonParser::commit(IOVariable *ioImage) {
+  defaultConfig = stage.device;
+  memcpy(ioImage, stage.ioVariables, sizeof(stage.ioVariables));
+  memcpy(conditions, stage.conditions, sizeof(conditions));
+  memcpy(conditionGroups, stage.conditionGroups, sizeof(conditionGroups));
+  memcpy(actions, stage.actions, sizeof(actions));
+  memcpy(actionGroups, stage.actionGroups, sizeof(actionGroups));
+  memcpy(rules, stage.rules, sizeof(rules));
+  memcpy(ruleSequence, stage.ruleSequence, sizeof(ruleSequence));
+  memcpy(schedules, stage.schedules, sizeof(schedules));
+}
+
+const deviceConfig &configJsonParser::stagedDevice() const {
+  return stage.device;
+}
+
+configView configJsonParser::stagedView() const {
+  return {&stage.device,        stage.ioVariables,  stage.conditions,
+          stage.conditionGroups, stage.actions,      stage.actionGroups,
+          stage.rules,           stage.ruleSequence, stage.schedules};
+}
+
+bool configJsonParser::consume(char c) {
+  switch (state) {
+    case PARSE_STRING:
+      if (c == '"') {
+        text[textLength] = '\0';
+        if (readingKey) {
+          frame &top = frames[depth - 1];
+          if (textTruncated || textLength >= CONFIG_KEY_SIZE) {
+            top.key[0] = '\0';  // Unknown key; its value is skipped
+          } else {
+            memcpy(top.key, text, textLength + 1);
+          }
+          readingKey = false;
+          state = PARSE_COLON;
+        } else {
+          store(VALUE_STRING);
+          endValue();
+        }
+      } else if (c == '\\') {
+        state = PARSE_ESCAPE;
+      } else if ((uint8_t)c < 0x20) {
+        return false;  // Raw control characters are not valid JSON
+      } else {
+        uint8_t byte = c;
+        appendBytes(&byte, 1);  // UTF-8 passes through unchanged
+      }
+      return true;
+    case PARSE_ESCAPE:
+      state = PARSE_STRING;
+      switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+          appendText(c);
+          return true;
+        case 'b':
+          appendText('\b');
+          return true;
+        case 'f':
+          appendText('\f');
+          return true;
+        case 'n':
+          appendText('\n');
+          return true;
+        case 'r':
+          appendText('\r');
+          return true;
+        case 't':
+          appendText('\t');
+          return true;
+        case 'u':
+          unicodeDigits = 0;
+          unicodeValue = 0;
+          state = PARSE_UNICODE;
+          return true;
+        default:
+          return false;
+      }
+    case PARSE_UNICODE: {
+      int8_t digit = (c >= '0' && c <= '9')   ? c - '0'
+                     : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                     : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+                                              : -1;
+      if (digit < 0) return false;
+      unicodeValue = (unicodeValue << 4) | digit;
+      if (++unicodeDigits < 4) return true;
+      state = PARSE_STRING;
+      if (unicodeValue >= 0xD800 && unicodeValue < 0xDC00) {
+        highSurrogate = unicodeValue;  // Combined with the next \u escape
+      } else if (unicodeValue >= 0xDC00 && unicodeValue < 0xE000 &&
+                 highSurrogate != 0) {
+        appendText(0x10000 + ((uint32_t)(highSurrogate - 0xD800) << 10) +
+                   (unicodeValue - 0xDC00));
+      } else {
+        appendText(unicodeValue);
+      }
+      return true;
+    }
+    case PARSE_SCALAR:
+      if (isalnum((uint8_t)c) || c == '-' || c == '+' || c == '.') {
+        if (scalarLength >= sizeof(scalar) - 1) return false;
+        scalar[scalarLength++] = c;
+        return true;
+      }
+      if (!endScalar()) return false;
+      return consume(c);  // The delimiter belongs to the enclosing state
+    default:
+      break;
+  }
+
+  if (isSpace(c)) return true;
+  switch (state) {
+    case PARSE_VALUE:
+      return beginValue(c);
+    case PARSE_ARRAY_START:
+      return c == ']' ? closeContainer(true) : beginValue(c);
+    case PARSE_OBJECT_START:
+      if (c == '}') return closeContainer(false);
+      // fall through
+    case PARSE_KEY:
+      if (c != '"') return false;
+      readingKey = true;
+      textTruncated = false;
+      textLength = 0;
+      state = PARSE_STRING;
+      return true;
+    case PARSE_COLON:
+      if (c != ':') return false;
+      state = PARSE_VALUE;
+      return true;
+    case PARSE_AFTER_VALUE:
+      if (c == ',') {
+        state = frames[depth - 1].isArray ? PARSE_VALUE : PARSE_KEY;
+        return true;
+      }
+      if (c == ']') return closeContainer(true);
+      if (c == '}') return closeContainer(false);
+      return false;
+    default:
+      return false;  // Anything after the root value, or a previous error
+  }
+}
+
+bool configJsonParser::beginValue(char c) {
+  if (depth == baseDepth) {
+    // The document is an object, a section an array (an object for
+    // deviceSettings) and an element an object; a stray scalar root would
+    // otherwise pass as a complete, empty document
+    bool wantArray = depth == 1 && !keyIs(frames[0].key, "deviceSettings");
+    if (c != (wantArray ? '[' : '{')) return false;
+  }
+  if (c == '{') return openContainer(false);
+  if (c == '[') return openContainer(true);
+  if (c == '"') {
+    readingKey = false;
+    textTruncated = false;
+    textLength = 0;
+    state = PARSE_STRING;
+    return true;
+  }
+  if (isalnum((uint8_t)c) || c == '-') {
+    scalarLength = 0;
+    scalar[scalarLength++] = c;
+    state = PARSE_SCALAR;
+    return true;
+  }
+  return false;
+}
+
+// A value (scalar or container) is complete
+void configJsonParser::endValue() {
+  if (depth == baseDepth) {
+    rootDone = true;
+    state = PARSE_DONE;
+    return;
+  }
+  if (frames[depth - 1].isArray) frames[depth - 1].index++;
+  state = PARSE_AFTER_VALUE;
+}
+
+bool configJsonParser::openContainer(bool isArray) {
+  if (depth >= CONFIG_PARSER_DEPTH) return false;
+  frame &top = frames[depth++];
+  top.isArray = isArray;
+  top.index = 0;
+  top.key[0] = '\0';
+  if (isArray) {
+    openMemberList();
+  } else {
+    openElement();
+  }
+  state = isArray ? PARSE_ARRAY_START : PARSE_OBJECT_START;
+  return true;
+}
+
+bool configJsonParser::closeContainer(bool isArray) {
+  if (depth == baseDepth || frames[depth - 1].isArray != isArray) {
+    return false;
+  }
+  depth--;
+  endValue();
+  return true;
+}
+
+bool configJsonParser::endScalar() {
+  scalar[scalarLength] = '\0';
+  valueKind kind = VALUE_NUMBER;
+  if (keyIs(scalar, "true") || keyIs(scalar, "false")) {
+    kind = VALUE_BOOL;
+    number = scalar[0] == 't';
+  } else if (keyIs(scalar, "null")) {
+    kind = VALUE_NULL;
+  } else {
+    char *end;
+    if (strpbrk(scalar, ".eE") != nullptr) {
+      number = (int32_t)strtod(scalar, &end);
+    } else {
+      number = (int32_t)strtol(scalar, &end, 10);
+    }
+    if (end == scalar || *end != '\0') return false;
+  }
+  store(kind);
+  endValue();
+  return true;
+}
+
+// Text that does not fit is truncated, as strlcpy() would
+void configJsonParser::appendBytes(const uint8_t *bytes, uint8_t count) {
+  highSurrogate = 0;
+  if (textLength + count >= sizeof(text)) {
+    textTruncated = true;
+    return;
+  }
+  memcpy(text + textLength, bytes, count);
+  textLength += count;
+}
+
+// Appends an escaped code point as UTF-8
+void configJsonParser::appendText(uint32_t codePoint) {
+  uint8_t bytes[4];
+  uint8_t count;
+  if (codePoint < 0x80) {
+    bytes[0] = codePoint;
+    count = 1;
+  } else if (codePoint < 0x800) {
+    bytes[0] = 0xC0 | (codePoint >> 6);
+    bytes[1] = 0x80 | (codePoint & 0x3F);
+    count = 2;
+  } else if (codePoint < 0x10000) {
+    bytes[0] = 0xE0 | (codePoint >> 12);
+    bytes[1] = 0x80 | ((codePoint >> 6) & 0x3F);
+    bytes[2] = 0x80 | (codePoint & 0x3F);
+    count = 3;
+  } else {
+    bytes[0] = 0xF0 | (codePoint >> 18);
+    bytes[1] = 0x80 | ((codePoint >> 12) & 0x3F);
+    bytes[2] = 0x80 | ((codePoint >> 6) & 0x3F);
+    bytes[3] = 0x80 | (codePoint & 0x3F);
+    count = 4;
+  }
+  appendBytes(bytes, count);
+}
+
+// A group's member list is replaced as a whole, also when only the list is
+// edited (beginPart() without 'replace')
+void configJsonParser::openMemberList() {
+  if (depth != 4 || !frames[1].isArray || frames[2].isArray) return;
+  const char *section = frames[0].key;
+  uint16_t i = frames[1].index;
+  if (keyIs(section, "conditionGroups") && keyIs(frames[2].key, "ca") &&
+      i < MAX_CONDITION_GROUPS) {
+    memset(stage.conditionGroups[i].conditionArray, 0,
+           sizeof(stage.conditionGroups[i].conditionArray));
+  } else if (keyIs(section, "actionGroups") && keyIs(frames[2].key, "ar") &&
+             i < MAX_ACTION_GROUPS) {
+    memset(stage.actionGroups[i].actionArray, 0,
+           sizeof(stage.actionGroups[i].actionArray));
+  }
+}
+
+// An object opened at depth 3 is an element of a top-level array
+void configJsonParser::openElement() {
+  if (depth != 3 || !frames[1].isArray) return;
+  const char *section = frames[0].key;
+  uint16_t i = frames[1].index;
+  if (keyIs(section, "ioVariables")) {
+    if (i >= MAX_IO_VARIABLES) dropped++;
+  } else if (keyIs(section, "conditions")) {
+    if (i >= MAX_CONDITIONS) dropped++;
+  } else if (keyIs(section, "conditionGroups")) {
+    if (i >= MAX_CONDITION_GROUPS) {
+      dropped++;
+    } else if (replaceElements) {  // Members not listed are cleared
+      memset(stage.conditionGroups[i].conditionArray, 0,
+             sizeof(stage.conditionGroups[i].conditionArray));
+    }
+  } else if (keyIs(section, "actions")) {
+    if (i >= MAX_ACTIONS) dropped++;
+  } else if (keyIs(section, "actionGroups")) {
+    if (i >= MAX_ACTION_GROUPS) {
+      dropped++;
+    } else if (replaceElements) {
+      memset(stage.actionGroups[i].actionArray, 0,
+             sizeof(stage.actionGroups[i].actionArray));
+    }
+  } else if (keyIs(section, "schedules")) {
+    if (i >= MAX_SCHEDULES) dropped++;
+  } else if (keyIs(section, "rules")) {
+    if (i >= MAX_RULES) {
+      dropped++;
+    } else if (replaceElements) {  // Sources and targets default to none
+      stage.rules[i].useConditionGroup = false;
+      stage.rules[i].conditionSourceId = 0;
+      stage.rules[i].useActionGroup = false;
+      stage.rules[i].actionTargetId = 0;
+    }
+  }
+}
+
+void configJsonParser::store(valueKind kind) {
+  if (depth < 2) return;
+  bool isNumber = kind == VALUE_NUMBER;
+  bool isBool = kind == VALUE_BOOL;
+  const char *section = frames[0].key;
+
+  if (depth == 2 && !frames[1].isArray && keyIs(section, "deviceSettings")) {
+    deviceConfig &ds = stage.device;
+    const char *key = frames[1].key;
+    if (kind == VALUE_STRING && keyIs(key, "SSID")) {
+      strlcpy(ds.SSID, text, sizeof(ds.SSID));
+    } else if (kind == VALUE_STRING && keyIs(key, "PASS")) {
+      strlcpy(ds.PASS, text, sizeof(ds.PASS));
+    } else if (kind == VALUE_STRING && keyIs(key, "DeviceName")) {
+      strlcpy(ds.DeviceName, text, sizeof(ds.DeviceName));
+    } else if (kind == VALUE_STRING && keyIs(key, "ntpServer")) {
+      strlcpy(ds.ntpServer, text, sizeof(ds.ntpServer));
+    } else if (kind == VALUE_STRING && keyIs(key, "timeZone")) {
+      strlcpy(ds.timeZone, text, sizeof(ds.timeZone));
+    } else if (keyIs(key, "run")) {
+      assignIf(isBool, ds.run, number);
+    } else if (keyIs(key, "scanPeriod")) {
+      assignIf(isNumber, ds.scanPeriodMs,
+               constrain(number, MIN_SCAN_PERIOD_MS, MAX_SCAN_PERIOD_MS));
+    } else if (keyIs(key, "persistInterval")) {
+      assignIf(isNumber, ds.persistIntervalS,
+               constrain(number, MIN_PERSIST_INTERVAL_S,
+                         MAX_PERSIST_INTERVAL_S));
+    } else if (keyIs(key, "analogFilter")) {
+      assignIf(isNumber, ds.analogFilter,
+               constrain(number, 0, MAX_ANALOG_FILTER));
+    }
+    return;
+  }
+
+  if (depth == 2 && frames[1].isArray && keyIs(section, "ruleSequence")) {
+    uint16_t i = frames[1].index;
+    if (i >= MAX_RULES) {
+      dropped++;
+      return;
+    }
+    storeId(isNumber, stage.ruleSequence[i], MAX_RULES);
+    return;
+  }
+
+  if (depth == 4 && frames[1].isArray && !frames[2].isArray &&
+      frames[3].isArray) {  // Group member list
+    uint16_t i = frames[1].index;
+    uint16_t j = frames[3].index;
+    if (keyIs(section, "conditionGroups") && keyIs(frames[2].key, "ca") &&
+        i < MAX_CONDITION_GROUPS) {
+      if (j >= MAX_CONDITIONS_PER_GROUP) {
+        dropped++;
+        return;
+      }
+      storeId(isNumber, stage.conditionGroups[i].conditionArray[j],
+              MAX_CONDITIONS);
+    } else if (keyIs(section, "actionGroups") && keyIs(frames[2].key, "ar") &&
+               i < MAX_ACTION_GROUPS) {
+      if (j >= MAX_ACTIONS_PER_GROUP) {
+        dropped++;
+        return;
+      }
+      storeId(isNumber, stage.actionGroups[i].actionArray[j], MAX_ACTIONS);
+    }
+    return;
+  }
+
+  if (depth == 3 && frames[1].isArray && !frames[2].isArray) {
+    storeElement(kind);
+  }
+}
+
+// Logic ID within 1..limit, or 0 for unused; anything else would index past
+// this build's arrays and is stored as unused
+void configJsonParser::storeId(bool matches, logicId &field, uint16_t limit) {
+  if (!matches) return;
+  if (number < 0 || number > limit) {
+    field = 0;
+    rejected++;
+    return;
+  }
+  field = (logicId)number;
+}
+
+// Field of an element of a top-level array; out-of-range indexes are skipped
+void configJsonParser::storeElement(valueKind kind) {
+  bool isNumber = kind == VALUE_NUMBER;
+  bool isBool = kind == VALUE_BOOL;
+  const char *section = frames[0].key;
+  const char *key = frames[2].key;
+  uint16_t i = frames[1].index;
+
+  if (keyIs(section, "ioVariables")) {
+    if (i >= MAX_IO_VARIABLES) return;
+    IOVariable &io = stage.ioVariables[i];
+    if (keyIs(key, "n")) assignIf(isNumber, io.num, number);
+    if (keyIs(key, "t")) assignIf(isNumber, io.type, number);
+    if (keyIs(key, "g")) assignIf(isNumber, io.gpio, number);
+    if (keyIs(key, "m")) assignIf(isNumber, io.mode, number);
+    if (keyIs(key, "nm") && kind == VALUE_STRING) {
+      strlcpy(io.name, text, sizeof(io.name));
+    }
+    if (keyIs(key, "st")) assignIf(isBool, io.state, number);
+    if (keyIs(key, "v")) assignIf(isNumber, io.value, number);
+    if (keyIs(key, "f")) assignIf(isBool, io.flag, number);
+    if (keyIs(key, "s")) assignIf(isBool, io.status, number);
+  } else if (keyIs(section, "conditions")) {
+    if (i >= MAX_CONDITIONS) return;
+    condition &cond = stage.conditions[i];
+    if (keyIs(key, "cn")) storeId(isNumber, cond.conNum, MAX_CONDITIONS);
+    if (keyIs(key, "t")) assignIf(isNumber, cond.Type, number);
+    if (keyIs(key, "tn")) assignIf(isNumber, cond.targetNum, number);
+    if (keyIs(key, "cp")) assignIf(isNumber, cond.comp, number);
+    if (keyIs(key, "v")) assignIf(isNumber, cond.value, number);
+    if (keyIs(key, "s")) assignIf(isBool, cond.status, number);
+  } else if (keyIs(section, "conditionGroups")) {
+    if (i >= MAX_CONDITION_GROUPS) return;
+    conditionGroup &group = stage.conditionGroups[i];
+    if (keyIs(key, "n")) storeId(isNumber, group.num, MAX_CONDITION_GROUPS);
+    if (keyIs(key, "l")) assignIf(isNumber, group.Logic, number);
+    if (keyIs(key, "s")) assignIf(isBool, group.status, number);
+  } else if (keyIs(section, "actions")) {
+    if (i >= MAX_ACTIONS) return;
+    action &act = stage.actions[i];
+    if (keyIs(key, "an")) storeId(isNumber, act.actNum, MAX_ACTIONS);
+    if (keyIs(key, "t")) assignIf(isNumber, act.Type, number);
+    if (keyIs(key, "tn")) assignIf(isNumber, act.targetNum, number);
+    if (keyIs(key, "a")) assignIf(isNumber, act.action, number);
+    if (keyIs(key, "v")) assignIf(isNumber, act.value, number);
+    if (keyIs(key, "s")) assignIf(isBool, act.status, number);
+  } else if (keyIs(section, "actionGroups")) {
+    if (i >= MAX_ACTION_GROUPS) return;
+    actionGroup &group = stage.actionGroups[i];
+    if (keyIs(key, "n")) storeId(isNumber, group.num, MAX_ACTION_GROUPS);
+    if (keyIs(key, "s")) assignIf(isBool, group.status, number);
+  } else if (keyIs(section, "rules")) {
+    if (i >= MAX_RULES) return;
+    rule &ru = stage.rules[i];
+    if (keyIs(key, "n")) storeId(isNumber, ru.num, MAX_RULES);
+    if (keyIs(key, "cg")) assignIf(isBool, ru.useConditionGroup, number);
+    if (keyIs(key, "ci")) {
+      storeId(isNumber, ru.conditionSourceId, MAX_SOURCE_ID);
+    }
+    if (keyIs(key, "ag")) assignIf(isBool, ru.useActionGroup, number);
+    if (keyIs(key, "ai")) storeId(isNumber, ru.actionTargetId, MAX_TARGET_ID);
+    if (keyIs(key, "s")) assignIf(isBool, ru.status, number);
+  } else if (keyIs(section, "schedules")) {
+    if (i >= MAX_SCHEDULES) return;
+    schedule &sch = stage.schedules[i];
+    if (keyIs(key, "n")) assignIf(isNumber, sch.num, number);
+    if (keyIs(key, "d")) assignIf(isNumber, sch.days, number & 0x7F);
+    if (keyIs(key, "on")) {
+      assignIf(isNumber, sch.onMinute, constrain(number, 0, 1439));
+    }
+    if (keyIs(key, "off")) {
+      assignIf(isNumber, sch.offMinute, constrain(number, 0, 1439));
+    }
+  }
+}
+// --- End Streaming Parser ---
+
+configView liveConfigView() {
+  return {&defaultConfig, IOVariables,  conditions,   conditionGroups,
+          actions,        actionGroups, rules,        ruleSequence,
+          schedules};
+}
+
+bool parseJsonConfigString(const String &jsonString) {
+  static configJsonParser parser;
+  parser.begin();
+  parser.feed(jsonString.c_str(), jsonString.length());
+  if (!parser.finish()) return false;
+  parser.commit();
+  return true;
+}
@@ -0,0 +1,155 @@
+#ifndef CONFIG_JSON_H
+#define CONFIG_JSON_H
+
+#include <Arduino.h>
+
+#include "dataStructure.h"
+#include "processImage.h"
+
+// JSON (de)serialization of the configuration. Kept free of LittleFS and the
+// web server so the host build can load the same config.json files.
+
+// General Configuration
+struct deviceConfig {
+  char SSID[30];
+  char PASS[30];
+  char DeviceName[30];
+  bool run;                   // IF program runs or stop
+  uint8_t scanPeriodMs;       // Scan cycle period of the rule engine
+  uint16_t persistIntervalS;  // Retained values are written at most this often
+  uint8_t analogFilter;       // AnalogInput IIR shift, 0 = average only
+  char ntpServer[40];
+  char timeZone[40];  // POSIX TZ string for Schedule windows, e.g. "UTC0"
+};
+
+extern deviceConfig defaultConfig;
+
+// One complete configuration: the live arrays or an upload's staged copy
+struct configView {
+  const deviceConfig *device;
+  const IOVariable *ioVariables;
+  const condition *conditions;
+  const conditionGroup *conditionGroups;
+  const action *actions;
+  const actionGroup *actionGroups;
+  const rule *rules;
+  const logicId *ruleSequence;
+  const schedule *schedules;
+};
+
+configView liveConfigView();
+
+// Worst-case size of one streamed piece: an IOVariable with a fully escaped
+// name, or a group with every member set (",65535" with 16-bit IDs)
+#define CONFIG_STREAM_PIECE_SIZE                           \
+  (128 + 6 * sizeof(IOVariable::name) +                    \
+   (sizeof(logicId) == 1 ? 4 : 6) *                        \
+       (MAX_CONDITIONS_PER_GROUP > MAX_ACTIONS_PER_GROUP   \
+            ? MAX_CONDITIONS_PER_GROUP                     \
+            : MAX_ACTIONS_PER_GROUP))
+
+// Streams the configuration as JSON straight from the global arrays, one
+// element at a time. Needs no JsonDocument and no heap; output is the same
+// document generateJsonConfigString() returns.
+class configJsonStream {
+ public:
+  configJsonStream() { begin(); }
+  void begin();
+  // Copies the next bytes of JSON into 'buffer'; returns 0 once complete
+  size_t read(uint8_t *buffer, size_t maxLen);
+
+ private:
+  bool renderNext();
+  void openElement(const char *key);
+  void closeElement(uint16_t count);
+  processEntry runtimeOf(uint8_t slot);
+  void append(const char *format, ...);
+  void appendString(const char *text);
+  const char *boolText(bool value) { return value ? "true" : "false"; }
+
+  uint8_t section;
+  uint16_t index;
+  uint16_t pieceLength;
+  uint16_t piecePos;
+  char piece[CONFIG_STREAM_PIECE_SIZE];
+  // Runtime fields as of begin(), consistent across all IOVariables
+  bool hasSnapshot;
+  processImage snapshot;
+};
+
+// Incremental (SAX-style) parser for the config JSON. Chunks are consumed as
+// they arrive and values go straight into a staged copy of the arrays, so
+// memory use is fixed no matter how large the upload is. Fields missing from
+// the document keep their current values; elements past an array's limit are
+// skipped and counted. IDs beyond the capacity profile's limits (a config
+// from a larger build) are stored as 0, "unused", and counted separately.
+#define CONFIG_PARSER_DEPTH 6
+#define CONFIG_KEY_SIZE 16
+#define CONFIG_NO_INDEX 0xFFFF  // beginPart(): the whole section
+
+class configJsonParser {
+ public:
+  void begin();  // Stages a copy of the live configuration
+  // Parses a document holding only part of the configuration: element
+  // 'index' of the array 'section' (an object), or with CONFIG_NO_INDEX the
+  // section's value itself. Everything else, device settings and rule order
+  // included, stays as it is live. 'replace' gives elements the same
+  // defaults as a full upload (group members and rule sources cleared);
+  // otherwise only the fields present change.
+  void beginPart(const char *section, uint16_t index, bool replace);
+  bool feed(const char *data, size_t len);  // false once the input is invalid
+  bool finish();  // true if exactly one complete document was parsed
+  // Copies the staged configuration into the live arrays, with the
+  // IOVariables going to 'ioImage'
+  void commit(IOVariable *ioImage = IOVariables);
+  const deviceConfig &stagedDevice() const;
+  configView stagedView() const;  // What commit() would make live
+  uint16_t droppedElements() const { return dropped; }
+  uint16_t rejectedIds() const { return rejected; }
+
+ private:
+  struct frame {
+    bool isArray;
+    uint16_t index;              // Element index (arrays)
+    char key[CONFIG_KEY_SIZE];   // Most recent key (objects), "" if unknown
+  };
+  enum valueKind : uint8_t { VALUE_NUMBER, VALUE_BOOL, VALUE_STRING, VALUE_NULL };
+
+  bool consume(char c);
+  bool beginValue(char c);
+  void endValue();
+  bool openContainer(bool isArray);
+  bool closeContainer(bool isArray);
+  bool endScalar();
+  void appendBytes(const uint8_t *bytes, uint8_t count);
+  void appendText(uint32_t codePoint);
+  void openElement();
+  void openMemberList();
+  void store(valueKind kind);
+  void storeElement(valueKind kind);
+  void storeId(bool matches, logicId &field, uint16_t limit);
+
+  uint8_t state;
+  uint8_t depth;
+  uint8_t baseDepth;     // Depth at which the document is complete
+  bool replaceElements;  // Opening an element resets it to its defaults
+  bool readingKey;
+  bool textTruncated;
+  bool rootDone;
+  uint16_t dropped;
+  uint16_t rejected;
+  uint8_t unicodeDigits;
+  uint16_t unicodeValue;
+  uint16_t highSurrogate;
+  uint8_t textLength;
+  char text[sizeof(IOVariable::name)];  // Current string value, truncated
+  uint8_t scalarLength;
+  char scalar[24];  // Current number or literal
+  int32_t number;
+  frame frames[CONFIG_PARSER_DEPTH];
+};
+
+String generateJsonConfigString();
+bool parseJsonConfigString(const String& jsonString);
+
+#endif  // CONFIG_JSON_H
@@ -1,288 +1,203 @@
 #include "configPortal.h"
 
 #include <ESPmDNS.h>
+
+#include <esp_timer.h>
+
+#include <memory>
+
+#include "configApi.h"
+#include "configBinary.h"
+#include "configStore.h"
+#include "configValidator.h"
+#include "eventRecorder.h"
+#include "liveStream.h"
+#include "metrics.h"
+#include "ruleEngine.h"
+#include "scanEngine.h"
+#include "webAssets.h"
+
 #define defaultSSID "advancedtimer"
 #define defaultPASS "12345678"
 
 AsyncWebServer server(80);
 
-const char *CONFIG_FILE = "/config.json";
+uint32_t configLoadUs = 0;
 
-// General Configuration
-struct deviceConfig {
-  char SSID[30];
-  char PASS[30];
-  char DeviceName[30];
-  bool run;  // IF program runs or stop
-};
+// One upload is parsed at a time; a newer upload takes over the parser
+static configJsonParser uploadParser;
+static AsyncWebServerRequest *uploadRequest = nullptr;
 
-deviceConfig defaultConfig = {"advancedtimer", "12345678", "AdvancedTimer",
-                              false};
-
-bool saveConfigToFile() {
-  String jsonConfig = generateJsonConfigString();
-  File configFile = LittleFS.open(CONFIG_FILE, FILE_WRITE);
-  if (!configFile) {
-    return false;  // Failed to open file for writing
+// Loads the snapshot if it matches this build and the current config.json
+static bool loadConfigBinary() {
+  if (!LittleFS.exists(CONFIG_BINARY_FILE) || !LittleFS.exists(CONFIG_FILE)) {
+    return false;
   }
-  size_t bytesWritten = configFile.print(jsonConfig);
+  File configFile = LittleFS.open(CONFIG_FILE, FILE_READ);
+  if (!configFile) return false;
+  uint32_t jsonSize = configFile.size();
   configFile.close();
-  return bytesWritten > 0;  // Return true if something was written
+  File binaryFile = LittleFS.open(CONFIG_BINARY_FILE, FILE_READ);
+  if (!binaryFile) return false;
+  bool ok = readConfigBinary(binaryFile, jsonSize);
+  binaryFile.close();
+  return ok;
 }
 
-void initiateConfig() {
-  if (!LittleFS.begin()) {
-    CreateDefaultIOVariables();
-    InitializeDefaultLogicComponents();
-    return;
-  }
-
-  if (LittleFS.exists(CONFIG_FILE)) {
-    File configFile = LittleFS.open(CONFIG_FILE, FILE_READ);
-    if (configFile) {
-      String configData = configFile.readString();
-      configFile.close();
-      parseJsonConfigString(configData);  // Load existing config
-    } else {
-      // File exists but couldn't be opened? Fallback to defaults.
-      CreateDefaultIOVariables();
-      InitializeDefaultLogicComponents();
-      saveConfigToFile();  // Try to save defaults even if read failed
-    }
-  } else {
-    // Config file doesn't exist, create defaults and save
-    CreateDefaultIOVariables();
-    InitializeDefaultLogicComponents();
-    saveConfigToFile();
-  }
+configJsonParser &claimConfigParser(AsyncWebServerRequest *request) {
+  uploadRequest = request;
+  return uploadParser;
 }
 
-String generateJsonConfigString() {
-  JsonDocument doc;
-
-  JsonObject deviceSettings = doc["deviceSettings"].to<JsonObject>();
-  deviceSettings["SSID"] = defaultConfig.SSID;
-  deviceSettings["PASS"] = defaultConfig.PASS;
-  deviceSettings["DeviceName"] = defaultConfig.DeviceName;
-  deviceSettings["run"] = defaultConfig.run;
+configJsonParser *heldConfigParser(AsyncWebServerRequest *request) {
+  return request == uploadRequest ? &uploadParser : nullptr;
+}
 
-  JsonArray ioVariablesArray = doc["ioVariables"].to<JsonArray>();
-  size_t numIOVariables = sizeof(IOVariables) / sizeof(IOVariables[0]);
-  for (size_t i = 0; i < numIOVariables; i++) {
-    JsonObject ioVariable = ioVariablesArray.add<JsonObject>();
-    ioVariable["n"] = IOVariables[i].num;
-    ioVariable["t"] = IOVariables[i].type;
-    ioVariable["g"] = IOVariables[i].gpio;
-    ioVariable["m"] = IOVariables[i].mode;
-    ioVariable["nm"] = IOVariables[i].name;
-    ioVariable["st"] = IOVariables[i].state;
-    ioVariable["v"] = IOVariables[i].value;
-    ioVariable["f"] = IOVariables[i].flag;
-    ioVariable["s"] = IOVariables[i].status;
-  }
-  JsonArray conditionsArray = doc["conditions"].to<JsonArray>();
-  size_t numConditions = sizeof(conditions) / sizeof(conditions[0]);
-  for (size_t i = 0; i < numConditions; i++) {
-    JsonObject condition = conditionsArray.add<JsonObject>();
-    condition["cn"] = conditions[i].conNum;
-    condition["t"] = conditions[i].Type;
-    condition["tn"] = conditions[i].targetNum;
-    condition["cp"] = conditions[i].comp;
-    condition["v"] = conditions[i].value;
-    condition["s"] = conditions[i].status;
-  }
-  JsonArray conditionGroupsArray = doc["conditionGroups"].to<JsonArray>();
-  size_t numConditionGroups =
-      sizeof(conditionGroups) / sizeof(conditionGroups[0]);
-  for (size_t i = 0; i < numConditionGroups; i++) {
-    JsonObject conditionGroup = conditionGroupsArray.add<JsonObject>();
-    conditionGroup["n"] = conditionGroups[i].num;
-    JsonArray conditionArray = conditionGroup["ca"].to<JsonArray>();
-    for (uint8_t j = 0; j < MAX_CONDITIONS_PER_GROUP; j++) {
-      conditionArray.add(conditionGroups[i].conditionArray[j]);
-    }
-    conditionGroup["l"] = conditionGroups[i].Logic;
-    conditionGroup["s"] = conditionGroups[i].status;
-  }
-  JsonArray actionsArray = doc["actions"].to<JsonArray>();
-  size_t numActions = sizeof(actions) / sizeof(actions[0]);
-  for (size_t i = 0; i < numActions; i++) {
-    JsonObject action = actionsArray.add<JsonObject>();
-    action["an"] = actions[i].actNum;
-    action["t"] = actions[i].Type;
-    action["tn"] = actions[i].targetNum;
-    action["a"] = actions[i].action;
-    action["v"] = actions[i].value;
-    action["s"] = actions[i].status;
-  }
-  JsonArray actionGroupsArray = doc["actionGroups"].to<JsonArray>();
-  size_t numActionGroups = sizeof(actionGroups) / sizeof(actionGroups[0]);
-  for (size_t i = 0; i < numActionGroups; i++) {
-    JsonObject actionGroup = actionGroupsArray.add<JsonObject>();
-    actionGroup["n"] = actionGroups[i].num;
-    JsonArray actionArray = actionGroup["ar"].to<JsonArray>();
-    for (uint8_t j = 0; j < MAX_ACTIONS_PER_GROUP; j++) {
-      actionArray.add(actionGroups[i].actionArray[j]);
-    }
-    actionGroup["s"] = actionGroups[i].status;
+void applyParsedConfig(AsyncWebServerRequest *request,
+                       configSectionId changed) {
+  uploadRequest = nullptr;
+  if (!uploadParser.finish()) {
+    request->send(400, "text/plain", "Failed to parse configuration JSON");
+    return;
   }
-  JsonArray rulesArray = doc["rules"].to<JsonArray>();
-  size_t numRules = sizeof(rules) / sizeof(rules[0]);
-  for (size_t i = 0; i < numRules; i++) {
-    JsonObject rule = rulesArray.add<JsonObject>();
-    rule["n"] = rules[i].num;
-    rule["cg"] = rules[i].useConditionGroup;
-    rule["ci"] = rules[i].conditionSourceId;
-    rule["ag"] = rules[i].useActionGroup;
-    rule["ai"] = rules[i].actionTargetId;
-    rule["s"] = rules[i].status;
+  if (uploadParser.droppedElements() > 0) {
+    Serial.printf("Config: %u elements beyond limits skipped\n",
+                  uploadParser.droppedElements());
   }
-  JsonArray ruleSequenceArray = doc["ruleSequence"].to<JsonArray>();
-  for (size_t i = 0; i < numRules; i++) {
-    ruleSequenceArray.add(ruleSequence[i]);
+  if (uploadParser.rejectedIds() > 0) {
+    Serial.printf("Config: %u IDs beyond limits unset\n",
+                  uploadParser.rejectedIds());
   }
-
-  String output;
-  size_t written = serializeJson(doc, output);
-  if (written > 0) {
-    return output;
-  } else {
-    Serial.println(
-        "ERROR: Failed to serialize current configuration to string.");
-    return "{}";  // Return empty JSON object on error
-  }
-}
-
-// --- Simplified JSON Parser (ArduinoJson v7) ---
-bool parseJsonConfigString(const String &jsonString) {
-  JsonDocument doc;  // ArduinoJson v7
-
-  // Attempt to deserialize, ignore errors for simplification
-  deserializeJson(doc, jsonString);
-
-  // --- Parse Device Settings (using full keys as generated) ---
-  JsonObject ds = doc["deviceSettings"];
-  strlcpy(defaultConfig.SSID, ds["SSID"] | "", sizeof(defaultConfig.SSID));
-  strlcpy(defaultConfig.PASS, ds["PASS"] | "", sizeof(defaultConfig.PASS));
-  strlcpy(defaultConfig.DeviceName, ds["DeviceName"] | "",
-          sizeof(defaultConfig.DeviceName));
-  defaultConfig.run = ds["run"] | false;
-
-  // --- Parse IO Variables (using full top-level key "ioVariables") ---
-  JsonArray ioArray = doc["ioVariables"];
-  int i_io = 0;
-  for (JsonObject ioVarJson : ioArray) {
-    // Assume index is within bounds
-    IOVariables[i_io].num = ioVarJson["n"] | IOVariables[i_io].num;
-    IOVariables[i_io].type =
-        (dataTypes)(ioVarJson["t"] | IOVariables[i_io].type);
-    IOVariables[i_io].gpio = ioVarJson["g"] | IOVariables[i_io].gpio;
-    IOVariables[i_io].mode =
-        (operationMode)(ioVarJson["m"] | IOVariables[i_io].mode);
-    strlcpy(IOVariables[i_io].name, ioVarJson["nm"] | IOVariables[i_io].name,
-            sizeof(IOVariables[i_io].name));
-    IOVariables[i_io].state = ioVarJson["st"] | IOVariables[i_io].state;
-    IOVariables[i_io].value = ioVarJson["v"] | IOVariables[i_io].value;
-    IOVariables[i_io].flag = ioVarJson["f"] | IOVariables[i_io].flag;
-    IOVariables[i_io].status = ioVarJson["s"] | IOVariables[i_io].status;
-    i_io++;
+  // Refused before anything changes: the running config stays as it is
+  static validationReport report;  // Only the async_tcp task gets here
+  validateConfig(uploadParser.stagedView(), report);
+  if (report.errors > 0) {
+    recordValidation(report, false);
+    String text = validationText(report);
+    Serial.println("Config rejected:");
+    Serial.print(text);
+    request->send(422, "text/plain", text);
+    return;
   }
+  if (report.warnings > 0) Serial.print(validationText(report));
+  recordValidation(report, true);
 
-  // --- Parse Conditions (using full top-level key "conditions") ---
-  JsonArray coArray = doc["conditions"];
-  int i_co = 0;
-  for (JsonObject condJson : coArray) {
-    conditions[i_co].conNum = condJson["cn"] | conditions[i_co].conNum;
-    conditions[i_co].Type = (dataTypes)(condJson["t"] | conditions[i_co].Type);
-    conditions[i_co].targetNum = condJson["tn"] | conditions[i_co].targetNum;
-    conditions[i_co].comp =
-        (comparisons)(condJson["cp"] | conditions[i_co].comp);
-    conditions[i_co].value = condJson["v"] | conditions[i_co].value;
-    conditions[i_co].status = condJson["s"] | conditions[i_co].status;
-    i_co++;
+  // Checked before anything changes, so an accepted edit is always saved
+  if (!canQueueConfigSave()) {
+    request->send(503, "text/plain", "Still saving earlier changes");
+    return;
   }
 
-  // --- Parse Condition Groups (using full top-level key "conditionGroups") ---
-  JsonArray cgArray = doc["conditionGroups"];
-  int i_cg = 0;
-  for (JsonObject cgJson : cgArray) {
-    conditionGroups[i_cg].num = cgJson["n"] | conditionGroups[i_cg].num;
-    conditionGroups[i_cg].Logic =
-        (combineLogic)(cgJson["l"] | conditionGroups[i_cg].Logic);
-    conditionGroups[i_cg].status = cgJson["s"] | conditionGroups[i_cg].status;
-
-    JsonArray caJson = cgJson["ca"];
-    int j_ca = 0;
-    for (JsonVariant val : caJson) {
-      if (j_ca >= MAX_CONDITIONS_PER_GROUP) break;  // Keep this bounds check
-      conditionGroups[i_cg].conditionArray[j_ca] = val.as<uint8_t>() | 0;
-      j_ca++;
-    }
-    for (; j_ca < MAX_CONDITIONS_PER_GROUP; ++j_ca) {  // Zero fill rest
-      conditionGroups[i_cg].conditionArray[j_ca] = 0;
-    }
-    i_cg++;
-  }
+  const deviceConfig &staged = uploadParser.stagedDevice();
+  bool networkChanged =
+      strcmp(staged.SSID, defaultConfig.SSID) != 0 ||
+      strcmp(staged.PASS, defaultConfig.PASS) != 0 ||
+      strcmp(staged.DeviceName, defaultConfig.DeviceName) != 0;
+
+  // Build the next image off to the side, then switch to it at the next
+  // scan boundary; outputs and timers keep running. The handler waits for
+  // the switch (at most two scan periods, no flash involved): the spare
+  // image and program are not free for the next edit before it, and the
+  // reply below says the configuration is running.
+  beginConfigChange();
+  uploadParser.commit(spareIOVariables());
+  compileRuleProgram(*spareProgram(), spareIOVariables());
+  swapLogicImage();
+  endConfigChange();
+  Serial.printf("Config applied in %u us\n", (unsigned)scanStats.lastSwapUs);
+
+  // Flash is written by the storage task, retained values first; GET
+  // /storage reports when the generation is saved. WiFi changes restart the
+  // device after that.
+  uint32_t generation = queueConfigSave(changed, networkChanged);
+  request->send(202, "text/plain",
+                "Applied, saving as generation " + String(generation));
+}
 
-  // --- Parse Actions (using full top-level key "actions") ---
-  JsonArray acArray = doc["actions"];
-  int i_ac = 0;
-  for (JsonObject actJson : acArray) {
-    actions[i_ac].actNum = actJson["an"] | actions[i_ac].actNum;
-    actions[i_ac].Type = (dataTypes)(actJson["t"] | actions[i_ac].Type);
-    actions[i_ac].targetNum = actJson["tn"] | actions[i_ac].targetNum;
-    actions[i_ac].action = (actionType)(actJson["a"] | actions[i_ac].action);
-    actions[i_ac].value = actJson["v"] | actions[i_ac].value;
-    actions[i_ac].status = actJson["s"] | actions[i_ac].status;
-    i_ac++;
+// Streams a config file through the parser in small chunks, on top of
+// the defaults
+static bool loadConfigFromFile(const char *path) {
+  CreateDefaultIOVariables();  // Base for fields the file leaves out
+  InitializeDefaultLogicComponents();
+  File configFile = LittleFS.open(path, FILE_READ);
+  if (!configFile) return false;
+  uploadParser.begin();
+  uint8_t buffer[256];
+  size_t n;
+  bool ok = true;
+  while (ok && (n = configFile.read(buffer, sizeof(buffer))) > 0) {
+    ok = uploadParser.feed((const char *)buffer, n);
   }
+  configFile.close();
+  if (!ok || !uploadParser.finish()) return false;
+  uploadParser.commit();
+  return true;
+}
 
-  // --- Parse Action Groups (using full top-level key "actionGroups") ---
-  JsonArray agArray = doc["actionGroups"];
-  int i_ag = 0;
-  for (JsonObject agJson : agArray) {
-    actionGroups[i_ag].num = agJson["n"] | actionGroups[i_ag].num;
-    actionGroups[i_ag].status = agJson["s"] | actionGroups[i_ag].status;
-    JsonArray arJson = agJson["ar"];  // Use 'ar' as generated
-    int j_ar = 0;
-    for (JsonVariant val : arJson) {
-      if (j_ar >= MAX_ACTIONS_PER_GROUP) break;  // Keep this bounds check
-      actionGroups[i_ag].actionArray[j_ar] = val.as<uint8_t>() | 0;
-      j_ar++;
-    }
-    for (; j_ar < MAX_ACTIONS_PER_GROUP; ++j_ar) {  // Zero fill rest
-      actionGroups[i_ag].actionArray[j_ar] = 0;
-    }
-    i_ag++;
-  }
+// Power lost between the renames of a save: config.json is gone and the
+// temp file holds the newer generation. It becomes config.json if it is
+// complete and passes validation.
+static bool promoteTempConfig() {
+  static validationReport report;
+  if (!loadConfigFromFile(CONFIG_TEMP_FILE)) return false;
+  validateConfig(liveConfigView(), report);
+  if (report.errors > 0) return false;
+  if (!LittleFS.rename(CONFIG_TEMP_FILE, CONFIG_FILE)) return false;
+  Serial.println("Config file restored from an interrupted save");
+  return true;
+}
 
-  // --- Parse Rules (using full top-level key "rules") ---
-  JsonArray ruArray = doc["rules"];
-  int i_ru = 0;
-  for (JsonObject ruleJson : ruArray) {
-    rules[i_ru].num = ruleJson["n"] | rules[i_ru].num;
-    rules[i_ru].useConditionGroup = ruleJson["cg"] | false;
-    rules[i_ru].conditionSourceId = ruleJson["ci"] | 0;
-    rules[i_ru].useActionGroup = ruleJson["ag"] | false;
-    rules[i_ru].actionTargetId = ruleJson["ai"] | 0;
-    rules[i_ru].status = ruleJson["s"] | rules[i_ru].status;
-    i_ru++;
+void initiateConfig() {
+  int64_t startUs = esp_timer_get_time();
+  const char *source = "defaults";
+  if (!LittleFS.begin()) {
+    CreateDefaultIOVariables();
+    InitializeDefaultLogicComponents();
+    return;
   }
 
-  // --- Parse Rule Sequence (using full top-level key "ruleSequence") ---
-  JsonArray rsArray = doc["ruleSequence"];
-  int i_rs = 0;
-  size_t maxRules = sizeof(rules) / sizeof(rules[0]);
-  for (JsonVariant val : rsArray) {
-    if (i_rs >= maxRules) break;  // Keep this bounds check
-    ruleSequence[i_rs] = val.as<uint8_t>() | (i_rs + 1);
-    i_rs++;
-  }
-  for (; i_rs < maxRules; ++i_rs) {  // Default fill rest
-    ruleSequence[i_rs] = i_rs + 1;
+  bool hasConfig = LittleFS.exists(CONFIG_FILE);
+  bool hasBackup = LittleFS.exists(CONFIG_BACKUP_FILE);
+  bool hasTemp = !hasConfig && LittleFS.exists(CONFIG_TEMP_FILE);
+  if (hasTemp) hasConfig = promoteTempConfig();
+  if (loadConfigBinary()) {
+    source = CONFIG_BINARY_FILE;
+  } else if (hasConfig && loadConfigFromFile(CONFIG_FILE)) {
+    source = CONFIG_FILE;
+    // Snapshot missing, stale or from another build: write a fresh one
+    File configFile = LittleFS.open(CONFIG_FILE, FILE_READ);
+    uint32_t jsonSize = configFile ? configFile.size() : 0;
+    configFile.close();
+    saveConfigBinary(jsonSize);
+  } else if (hasBackup && loadConfigFromFile(CONFIG_BACKUP_FILE)) {
+    // config.json unreadable, or lost between the renames of a save with a
+    // temp file that did not load: the previous generation becomes
+    // config.json again
+    source = CONFIG_BACKUP_FILE;
+    Serial.println("Config file invalid, using the previous generation");
+    LittleFS.remove(CONFIG_FILE);  // Must not become the backup
+    saveConfig(CONFIG_SECTIONS);
+  } else if (hasConfig || hasBackup || hasTemp) {
+    // Unreadable or invalid; run on defaults but keep the files as they are
+    Serial.println("Config file invalid, using defaults");
+    CreateDefaultIOVariables();
+    InitializeDefaultLogicComponents();
+  } else {
+    // Config file doesn't exist, create defaults and save
+    CreateDefaultIOVariables();
+    InitializeDefaultLogicComponents();
+    saveConfig(CONFIG_SECTIONS);
   }
-
-  return true;  // Assume success
+  configLoadUs = (uint32_t)(esp_timer_get_time() - startUs);
+  Serial.printf("Config loaded from %s in %u us\n", source,
+                (unsigned)configLoadUs);
+
+  // A stored config still runs if it fails today's checks; it was accepted
+  // by an earlier firmware or written before validation existed
+  static validationReport report;
+  validateConfig(liveConfigView(), report);
+  recordValidation(report, true);
+  Serial.print(validationText(report));
 }
 
 bool initiateWiFi() {
@@ -317,18 +232,19 @@ bool initiateWiFi() {
 
 // --- Web Server Setup --- <<< Add This Section
 void setupWebServer() {
-  // Serve Static Files from LittleFS
-  server.serveStatic("/", LittleFS, "/").setDefaultFile("index.html");
-  server.serveStatic("/style.css", LittleFS, "/style.css");
-  server.serveStatic("/bootstrap.min.css", LittleFS, "/bootstrap.min.css");
-  server.serveStatic("/script.js", LittleFS, "/script.js");
-  server.serveStatic("/Sortable.min.js", LittleFS, "/Sortable.min.js");
-  server.serveStatic("/favicon.ico", LittleFS, "/favicon.ico");
+  // Serve the gzipped web UI from LittleFS with ETag revalidation
+  setupWebAssets(server);
 
-  // Handle GET request for configuration
+  // Handle GET request for configuration: streamed in chunks straight from
+  // the arrays, so only one small stream object lives on the heap per request
   server.on("/config", HTTP_GET, [](AsyncWebServerRequest *request) {
-    String jsonConfig = generateJsonConfigString();
-    request->send(200, "application/json", jsonConfig);
+    std::shared_ptr<configJsonStream> stream =
+        std::make_shared<configJsonStream>();
+    request->send(request->beginChunkedResponse(
+        "application/json",
+        [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+          return stream->read(buffer, maxLen);
+        }));
   });
 
   // Handle POST request for configuration
@@ -337,41 +253,29 @@ void setupWebServer() {
       NULL,  // No file upload handler needed here
       [](AsyncWebServerRequest *request, uint8_t *data, size_t len,
          size_t index, size_t total) {
-        static String bodyContent = "";
-        if (index == 0) {
-          bodyContent = "";
-          // Clear previous content
-          // Optional: Check Content-Type if needed
-          // if(request->contentType() != "application/json"){
-          //     request->send(400, "text/plain", "Bad Request: Expected
-          //     application/json"); return;
-          // }
+        if (index == 0) claimConfigParser(request).begin();
+        if (heldConfigParser(request) == nullptr) {  // Superseded
+          if (index + len == total) {
+            request->send(409, "text/plain", "Superseded by a newer upload");
+          }
+          return;
         }
 
-        // Append data chunk to bodyContent
-        bodyContent.concat((char *)data, len);
+        // Chunks are parsed as they arrive; nothing is buffered
+        uploadParser.feed((const char *)data, len);
 
         if (index + len == total) {  // Last chunk received
-          Serial.println("Received config POST:");
-          Serial.println(bodyContent);  // Print received JSON for debugging
-
-          if (parseJsonConfigString(bodyContent)) {
-            if (saveConfigToFile()) {
-              request->send(200, "text/plain", "OK");
-              // Schedule restart after sending response
-              delay(1000);  // Short delay to allow response to send
-              ESP.restart();
-            } else {
-              request->send(500, "text/plain", "Failed to save configuration");
-            }
-          } else {
-            request->send(400, "text/plain",
-                          "Failed to parse configuration JSON");
-          }
-          bodyContent = "";  // Clear buffer for next request
+          Serial.printf("Received config POST: %u bytes\n", (unsigned)total);
+          applyParsedConfig(request, CONFIG_SECTIONS);
         }
       });
 
+  setupConfigApi(server);   // Single-entity edits under /api
+  setupConfigStore(server);  // Save progress of uploads and edits
+  setupLiveStream(server);  // WebSocket with live IOVariable state
+  setupMetrics(server);     // Prometheus telemetry and request timing
+  setupEventDownload(server);
+
   // Handle Not Found
   server.onNotFound([](AsyncWebServerRequest *request) {
     request->send(404, "text/plain", "Not found");
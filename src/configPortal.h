@@ -2,22 +2,31 @@
 #define CONFIG_PORTAL_H
 
 #include <Arduino.h>
-// ArduinoJSON V7 StaticJSONDocument & DynamicJSON Document are depricated.
-#include <ArduinoJson.h>
 #include <ESPAsyncWebServer.h>
 #include <LittleFS.h>
 #include <WiFi.h>
 
+#include "configBinary.h"
+#include "configJson.h"
 #include "dataStructure.h"
 
 // Declare the server object
 extern AsyncWebServer server;  // <<< Add This
+extern uint32_t configLoadUs;  // Time initiateConfig() took at boot
 
 void initiateConfig();
-String generateJsonConfigString();
-bool parseJsonConfigString(const String& jsonString);
-bool saveConfigToFile();  // <<< Add prototype if not already present
 bool initiateWiFi();
+
+// The config parser is shared by POST /config and the /api edits. The newest
+// request takes it over; an older one still uploading gets 409.
+configJsonParser &claimConfigParser(AsyncWebServerRequest *request);
+// The parser if 'request' still holds it, nullptr otherwise
+configJsonParser *heldConfigParser(AsyncWebServerRequest *request);
+// Switches to the configuration the parser staged at the next scan boundary,
+// queues its save and sends the response. 'changed' is the only section an /api
+// edit touched, or CONFIG_SECTIONS after a full upload.
+void applyParsedConfig(AsyncWebServerRequest *request,
+                       configSectionId changed);
 void setupWebServer();  // <<< Add This: Function to configure server routes
 
 #endif  // CONFIG_PORTAL_H
@@ -0,0 +1,237 @@
+#include "configStore.h"
+
+#include <LittleFS.h>
+#include <esp_timer.h>
+
+#include <atomic>
+
+#include "configJson.h"
+#include "persistence.h"
+
+struct saveJob {
+  configSectionId changed;
+  uint32_t generation;
+  bool restart;
+};
+
+configStoreStatistics configStoreStats;
+
+static QueueHandle_t saveQueue = NULL;
+static TaskHandle_t storeTask = NULL;
+// Odd while the live configuration arrays are being changed
+static std::atomic<uint32_t> changeSequence(0);
+
+// --- Change Tracking ---
+void beginConfigChange() {
+  changeSequence.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void endConfigChange() {
+  changeSequence.fetch_add(1, std::memory_order_release);
+}
+
+// Sequence number to compare with once the configuration has been read
+static uint32_t waitForStableConfig() {
+  uint32_t sequence;
+  while ((sequence = changeSequence.load(std::memory_order_acquire)) & 1) {
+    vTaskDelay(1);
+  }
+  return sequence;
+}
+
+static bool changedSince(uint32_t sequence) {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return changeSequence.load(std::memory_order_relaxed) != sequence;
+}
+// --- End Change Tracking ---
+
+// --- File Writes ---
+// Streams the live configuration into 'path'; returns its size, 0 if the
+// file could not be written completely
+static uint32_t writeConfigJson(const char *path) {
+  File file = LittleFS.open(path, FILE_WRITE);
+  if (!file) return 0;
+  configJsonStream stream;
+  uint8_t buffer[256];
+  uint32_t written = 0;
+  size_t n;
+  while ((n = stream.read(buffer, sizeof(buffer))) > 0) {
+    if (file.write(buffer, n) != n) break;
+    written += n;
+  }
+  file.close();
+  if (n != 0) written = 0;
+  if (written == 0) LittleFS.remove(path);
+  return written;
+}
+
+static bool writeBinaryFile(const char *path, uint32_t jsonSize) {
+  File file = LittleFS.open(path, FILE_WRITE);
+  if (!file) return false;
+  bool ok = writeConfigBinary(file, jsonSize);
+  file.close();
+  if (!ok) LittleFS.remove(path);  // Never leave a torn copy
+  return ok;
+}
+
+bool saveConfigBinary(uint32_t jsonSize) {
+  return writeBinaryFile(CONFIG_BINARY_FILE, jsonSize);
+}
+
+// Closing the file commits the header before config.json is replaced
+static bool markBinaryStale() {
+  if (!LittleFS.exists(CONFIG_BINARY_FILE)) return false;
+  File file = LittleFS.open(CONFIG_BINARY_FILE, "r+");
+  if (!file) return false;
+  bool ok = markConfigBinaryStale(file);
+  file.close();
+  return ok;
+}
+
+static bool patchBinary(configSectionId section, uint32_t jsonSize) {
+  if (!LittleFS.exists(CONFIG_BINARY_FILE)) return false;
+  File file = LittleFS.open(CONFIG_BINARY_FILE, "r+");
+  if (!file) return false;
+  bool ok = patchConfigBinary(file, section, jsonSize);
+  file.close();
+  return ok;
+}
+
+// The temp file becomes config.json and the file it replaces the backup.
+// Each step is one LittleFS remove or rename, and after each one
+// config.json or the backup holds a complete configuration.
+static bool replaceConfigJson() {
+  if (LittleFS.exists(CONFIG_FILE)) {
+    LittleFS.remove(CONFIG_BACKUP_FILE);
+    if (!LittleFS.rename(CONFIG_FILE, CONFIG_BACKUP_FILE)) return false;
+  }
+  return LittleFS.rename(CONFIG_TEMP_FILE, CONFIG_FILE);
+}
+
+bool saveConfig(configSectionId changed) {
+  uint32_t sequence;
+  uint32_t jsonSize;
+  bool binaryReady = false;
+  for (uint8_t attempt = 0;; attempt++) {
+    sequence = waitForStableConfig();
+    jsonSize = writeConfigJson(CONFIG_TEMP_FILE);
+    if (jsonSize == 0) return false;
+    if (changed == CONFIG_SECTIONS) {
+      binaryReady = writeBinaryFile(CONFIG_BINARY_TEMP_FILE, jsonSize);
+    }
+    if (!changedSince(sequence)) break;
+    configStoreStats.rewrites++;
+    if (attempt == CONFIG_STORE_RETRIES) {
+      LittleFS.remove(CONFIG_TEMP_FILE);
+      LittleFS.remove(CONFIG_BINARY_TEMP_FILE);
+      return false;
+    }
+    changed = CONFIG_SECTIONS;  // Which sections the change touched is unknown
+  }
+
+  // The snapshot on flash describes the JSON about to be replaced
+  if (changed == CONFIG_SECTIONS || !markBinaryStale()) {
+    LittleFS.remove(CONFIG_BINARY_FILE);
+  }
+  if (!replaceConfigJson()) return false;
+
+  if (changed == CONFIG_SECTIONS) {
+    binaryReady =
+        binaryReady &&
+        LittleFS.rename(CONFIG_BINARY_TEMP_FILE, CONFIG_BINARY_FILE);
+  } else {
+    // Only the edited section is written; the rest is still current
+    binaryReady = patchBinary(changed, jsonSize) || saveConfigBinary(jsonSize);
+    if (changedSince(sequence)) {  // Read from a newer configuration
+      LittleFS.remove(CONFIG_BINARY_FILE);
+      binaryReady = false;
+    }
+  }
+  if (!binaryReady) Serial.println("Binary config snapshot not written");
+  return true;
+}
+// --- End File Writes ---
+
+// --- Storage Task ---
+bool canQueueConfigSave() {
+  return saveQueue == NULL || uxQueueSpacesAvailable(saveQueue) > 0;
+}
+
+uint32_t queueConfigSave(configSectionId changed, bool restart) {
+  saveJob job = {changed, ++configStoreStats.requested, restart};
+  if (saveQueue != NULL && xQueueSend(saveQueue, &job, 0) == pdTRUE) {
+    return job.generation;
+  }
+  // No task yet: save on the caller
+  if (saveConfig(changed)) {
+    configStoreStats.saved = job.generation;
+  } else {
+    configStoreStats.failures++;
+  }
+  return job.generation;
+}
+
+static void storeTaskFunction(void *pvParameters) {
+  saveJob job;
+  for (;;) {
+    if (xQueueReceive(saveQueue, &job, portMAX_DELAY) != pdTRUE) continue;
+    saveJob next;
+    while (xQueueReceive(saveQueue, &next, 0) == pdTRUE) {  // One save for all
+      if (next.changed != job.changed) job.changed = CONFIG_SECTIONS;
+      job.generation = next.generation;
+      job.restart = job.restart || next.restart;
+    }
+
+    // Edited presets and persistent values must not be overridden by older
+    // retained ones after a power loss, so they go to NVS before the config
+    flushRetainedValues();
+    int64_t startUs = esp_timer_get_time();
+    bool ok = saveConfig(job.changed);
+    uint32_t ms = (uint32_t)((esp_timer_get_time() - startUs) / 1000);
+    configStoreStats.lastSaveMs = ms;
+    if (ms > configStoreStats.maxSaveMs) configStoreStats.maxSaveMs = ms;
+    if (!ok) {
+      configStoreStats.failures++;
+      Serial.printf("Config generation %u not saved\n",
+                    (unsigned)job.generation);
+      continue;
+    }
+    configStoreStats.saved = job.generation;
+    Serial.printf("Config generation %u saved in %u ms\n",
+                  (unsigned)job.generation, (unsigned)ms);
+    if (job.restart) {  // WiFi settings only apply on boot
+      Serial.println("Restarting for the new network settings");
+      delay(500);
+      ESP.restart();
+    }
+  }
+}
+
+void startConfigStore() {
+  // Left over by a save that lost power before its renames. Without
+  // config.json the temp file may be the only copy of the newest
+  // generation (initiateConfig() could not promote it), so it stays.
+  if (LittleFS.exists(CONFIG_FILE)) {
+    LittleFS.remove(CONFIG_TEMP_FILE);
+    LittleFS.remove(CONFIG_BINARY_TEMP_FILE);
+  }
+  if (storeTask != NULL) return;
+  saveQueue = xQueueCreate(CONFIG_STORE_QUEUE, sizeof(saveJob));
+  xTaskCreatePinnedToCore(storeTaskFunction, "storeTask",
+                          CONFIG_STORE_TASK_STACK, NULL,
+                          CONFIG_STORE_TASK_PRIORITY, &storeTask,
+                          CONFIG_STORE_TASK_CORE);
+}
+
+void setupConfigStore(AsyncWebServer &server) {
+  server.on(CONFIG_STORE_PATH, HTTP_GET, [](AsyncWebServerRequest *request) {
+    char json[80];
+    snprintf(json, sizeof(json),
+             "{\"requested\":%u,\"saved\":%u,\"failures\":%u}",
+             (unsigned)configStoreStats.requested,
+             (unsigned)configStoreStats.saved,
+             (unsigned)configStoreStats.failures);
+    request->send(200, "application/json", json);
+  });
+}
+// --- End Storage Task ---
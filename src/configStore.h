@@ -0,0 +1,65 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#include "configBinary.h"
+
+// config.json and its binary snapshot on LittleFS. Saving an upload or an
+// /api edit is queued to a low-priority task, so the web handler answers
+// as soon as the configuration runs; GET /storage tells when it is on
+// flash ({"requested":n,"saved":n,"failures":n}, generations count from 1).
+// The task also writes the retained values (persistence.h) before each
+// save, so the web handler never waits on NVS either.
+//
+// A save writes complete temp files first and writes them again if the
+// live configuration changed meanwhile. Renames then replace the files:
+// config.json becomes config.json.bak (the previous generation, used at
+// boot when config.json is unreadable) and the temp file config.json. The
+// binary snapshot is marked stale before the JSON it belongs to is
+// replaced, so a power loss at any point leaves a consistent pair.
+
+#define CONFIG_FILE "/config.json"
+#define CONFIG_BACKUP_FILE "/config.json.bak"  // Previous generation
+#define CONFIG_TEMP_FILE "/config.json.tmp"
+#define CONFIG_BINARY_FILE "/config.bin"  // Fast boot copy of config.json
+#define CONFIG_BINARY_TEMP_FILE "/config.bin.tmp"
+#define CONFIG_STORE_PATH "/storage"
+
+#define CONFIG_STORE_QUEUE 4  // Waiting saves; more are refused with 503
+#define CONFIG_STORE_RETRIES 3  // Rewrites after overlapping changes
+
+#define CONFIG_STORE_TASK_CORE 0
+#define CONFIG_STORE_TASK_PRIORITY 1
+#define CONFIG_STORE_TASK_STACK 6144
+
+struct configStoreStatistics {
+  uint32_t requested;   // Generation of the newest queued save
+  uint32_t saved;       // Newest generation on flash
+  uint32_t failures;    // Saves that left the files as they were
+  uint32_t rewrites;    // Temp files written again after a change
+  uint32_t lastSaveMs;  // Duration of the last save
+  uint32_t maxSaveMs;
+};
+
+extern configStoreStatistics configStoreStats;
+
+// Around every change of the live configuration arrays (async_tcp task)
+void beginConfigChange();
+void endConfigChange();
+
+bool canQueueConfigSave();
+// Saves the live configuration in the background and returns the save's
+// generation. 'changed' is the only section that changed, or
+// CONFIG_SECTIONS; 'restart' reboots once the save is done.
+uint32_t queueConfigSave(configSectionId changed, bool restart);
+// Saves right away on the calling task; boot only
+bool saveConfig(configSectionId changed);
+// Rewrites config.bin for the config.json on flash; boot only
+bool saveConfigBinary(uint32_t jsonSize);
+
+void startConfigStore();
+void setupConfigStore(AsyncWebServer &server);  // GET /storage
+
+#endif  // CONFIG_STORE_H
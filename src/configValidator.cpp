@@ -0,0 +1,587 @@
+#include "configValidator.h"
+
+#include <driver/gpio.h>
+#include <stdarg.h>
+
+#define FLASH_GPIO_MASK (0x3FULL << 6)  // GPIO 6-11 drive the SPI flash
+#define ADC1_GPIO_MASK (0xFFULL << 32)  // GPIO 32-39
+#define ADC2_GPIO_MASK \
+  ((1ULL << 0) | (1ULL << 2) | (1ULL << 4) | (0xFULL << 12) | (0x7ULL << 25))
+
+validatorStatistics validatorStats;
+
+static const char *const typeNames[] = {"DigitalInput", "DigitalOutput",
+                                        "AnalogInput",  "SoftIO",
+                                        "Timer",        "Schedule"};
+
+// Runtime field a write lands in
+enum writeField : uint8_t { FIELD_STATE, FIELD_VALUE, FIELD_FLAG, FIELDS };
+
+// First rule seen writing each field, for conflict detection
+struct fieldWriter {
+  logicId ruleNum;  // 0 = nobody yet
+  actionType effect;
+  int32_t value;
+  bool reported;
+};
+
+// Working state of one validation; like the compiler scratch, only one
+// validation runs at a time and it stays off the stack
+struct validatorScratch {
+  uint16_t slotReads[MAX_IO_VARIABLES];  // Rule reads of each slot
+  fieldWriter writers[MAX_IO_VARIABLES][FIELDS];
+  bool sequenced[MAX_RULES + 1];
+};
+
+static validatorScratch scratch;
+
+static void addIssue(validationReport &report, issueSeverity severity,
+                     const char *format, ...) {
+  if (severity == ISSUE_ERROR) {
+    report.errors++;
+  } else {
+    report.warnings++;
+  }
+  if (report.stored >= VALIDATION_MAX_ISSUES) return;
+  validationIssue &issue = report.issues[report.stored++];
+  issue.severity = severity;
+  va_list args;
+  va_start(args, format);
+  vsnprintf(issue.message, sizeof(issue.message), format, args);
+  va_end(args);
+}
+
+// --- Lookups (any status; callers check it) ---
+static int16_t findSlot(const configView &config, dataTypes type,
+                        uint8_t num) {
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    const IOVariable &io = config.ioVariables[i];
+    if (io.type == type && io.num == num) return i;
+  }
+  return -1;
+}
+
+static const condition *findCondition(const configView &config,
+                                      logicId conNum) {
+  for (logicId i = 0; i < MAX_CONDITIONS; i++) {
+    const condition &cond = config.conditions[i];
+    if (cond.status && cond.conNum == conNum) return &cond;
+  }
+  return nullptr;
+}
+
+static const action *findAction(const configView &config, logicId actNum) {
+  for (logicId i = 0; i < MAX_ACTIONS; i++) {
+    const action &act = config.actions[i];
+    if (act.status && act.actNum == actNum) return &act;
+  }
+  return nullptr;
+}
+
+static const conditionGroup *findConditionGroup(const configView &config,
+                                                logicId num) {
+  for (logicId i = 0; i < MAX_CONDITION_GROUPS; i++) {
+    const conditionGroup &group = config.conditionGroups[i];
+    if (group.status && group.num == num) return &group;
+  }
+  return nullptr;
+}
+
+static const actionGroup *findActionGroup(const configView &config,
+                                          logicId num) {
+  for (logicId i = 0; i < MAX_ACTION_GROUPS; i++) {
+    const actionGroup &group = config.actionGroups[i];
+    if (group.status && group.num == num) return &group;
+  }
+  return nullptr;
+}
+
+// First window with 'num', as the scheduler picks it
+static const schedule *findSchedule(const configView &config, uint8_t num) {
+  for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+    if (config.schedules[i].num == num) return &config.schedules[i];
+  }
+  return nullptr;
+}
+
+static const rule *findRule(const configView &config, logicId num) {
+  for (logicId i = 0; i < MAX_RULES; i++) {
+    const rule &ru = config.rules[i];
+    if (ru.status && ru.num == num) return &ru;
+  }
+  return nullptr;
+}
+
+// Enabled target slot, or -1 after reporting why not
+static int16_t checkTarget(const configView &config, validationReport &report,
+                           const char *kind, logicId id, dataTypes type,
+                           uint8_t num) {
+  if ((unsigned)type > Schedule) {
+    addIssue(report, ISSUE_ERROR, "%s %u: unknown target type %d", kind, id,
+             type);
+    return -1;
+  }
+  int16_t slot = findSlot(config, type, num);
+  if (slot < 0 || !config.ioVariables[slot].status) {
+    addIssue(report, ISSUE_ERROR, "%s %u: %s %u missing or disabled", kind,
+             id, typeNames[type], num);
+    return -1;
+  }
+  return slot;
+}
+// --- End Lookups ---
+
+// --- IOVariable Checks ---
+// Type each slot range holds (dataStructure.h); the Modbus register map
+// and the event ranges index by it
+static dataTypes slotType(uint8_t slot) {
+  if (slot < FIRST_DIGITAL_OUT) return DigitalInput;
+  if (slot < FIRST_ANALOG_IN) return DigitalOutput;
+  if (slot < FIRST_SOFTIO) return AnalogInput;
+  if (slot < FIRST_TIMER) return SoftIO;
+  if (slot < FIRST_SCHEDULE) return Timer;
+  return Schedule;
+}
+
+// The modes the web UI offers for each type
+static bool validMode(dataTypes type, operationMode mode) {
+  switch (type) {
+    case DigitalInput:
+      return mode == none || mode == rising || mode == falling ||
+             mode == stateChange;
+    case DigitalOutput:
+      return mode == none || mode == startDelay || mode == autoOff;
+    case AnalogInput:
+      return mode == none || mode == scaled;
+    case SoftIO:
+      return mode == none || mode == persistent;
+    case Timer:
+      return mode == oneShot || mode == repeating;
+    default:
+      return mode == none;
+  }
+}
+
+static bool usesPin(dataTypes type) {
+  return type == DigitalInput || type == DigitalOutput || type == AnalogInput;
+}
+
+// Reports a pin 'io' cannot use; ADC2 pins only warn, they read while
+// WiFi is off
+static void checkPin(const IOVariable &io, validationReport &report) {
+  const char *type = typeNames[io.type];
+  uint64_t bit = io.gpio < 64 ? 1ULL << io.gpio : 0;
+  if (!GPIO_IS_VALID_GPIO(io.gpio) || (bit & FLASH_GPIO_MASK)) {
+    addIssue(report, ISSUE_ERROR, "%s %u: GPIO %u is not usable", type,
+             io.num, io.gpio);
+  } else if (io.type == DigitalOutput && !GPIO_IS_VALID_OUTPUT_GPIO(io.gpio)) {
+    addIssue(report, ISSUE_ERROR, "%s %u: GPIO %u is input only", type,
+             io.num, io.gpio);
+  } else if (io.type == AnalogInput && (bit & ADC2_GPIO_MASK)) {
+    addIssue(report, ISSUE_WARNING, "%s %u: GPIO %u is ADC2, no reads on WiFi",
+             type, io.num, io.gpio);
+  } else if (io.type == AnalogInput && !(bit & ADC1_GPIO_MASK)) {
+    addIssue(report, ISSUE_ERROR, "%s %u: GPIO %u has no ADC", type, io.num,
+             io.gpio);
+  }
+}
+
+static void checkIOVariables(const configView &config,
+                             validationReport &report) {
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    const IOVariable &io = config.ioVariables[i];
+    if ((unsigned)io.type > Schedule) {
+      addIssue(report, ISSUE_ERROR, "IOVariable slot %u: unknown type %d", i,
+               io.type);
+      continue;
+    }
+    if (io.type != slotType(i)) {
+      addIssue(report, ISSUE_ERROR, "IOVariable slot %u: %s, expected %s", i,
+               typeNames[io.type], typeNames[slotType(i)]);
+      continue;
+    }
+    // References resolve to the first slot with the number, enabled or not
+    if (findSlot(config, io.type, io.num) != i) {
+      addIssue(report, ISSUE_ERROR, "%s %u: ID used twice", typeNames[io.type],
+               io.num);
+    }
+    if (!io.status) continue;
+    if (!validMode(io.type, io.mode)) {
+      addIssue(report, ISSUE_ERROR, "%s %u: mode %d not allowed",
+               typeNames[io.type], io.num, io.mode);
+    }
+    if (!usesPin(io.type)) continue;
+    checkPin(io, report);
+    for (uint8_t j = 0; j < i; j++) {
+      const IOVariable &other = config.ioVariables[j];
+      if (other.status && usesPin(other.type) && other.gpio == io.gpio) {
+        addIssue(report, ISSUE_ERROR, "%s %u: GPIO %u also used by %s %u",
+                 typeNames[io.type], io.num, io.gpio, typeNames[other.type],
+                 other.num);
+        break;
+      }
+    }
+  }
+}
+
+// A window that never opens (no weekday, or on == off) is an unused entry
+static bool windowOpens(const schedule &window) {
+  return window.days != 0 && window.onMinute != window.offMinute;
+}
+
+static void checkSchedules(const configView &config,
+                           validationReport &report) {
+  for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+    const schedule &window = config.schedules[i];
+    if (window.num == 0) continue;
+    if (findSchedule(config, window.num) != &window) {
+      addIssue(report, ISSUE_ERROR, "Schedule window %u: ID used twice",
+               window.num);
+      continue;
+    }
+    if (!windowOpens(window)) continue;
+    int16_t slot = findSlot(config, Schedule, window.num);
+    if (slot < 0 || !config.ioVariables[slot].status) {
+      addIssue(report, ISSUE_ERROR,
+               "Schedule window %u: Schedule missing or disabled", window.num);
+    }
+  }
+  for (uint8_t i = FIRST_SCHEDULE; i < MAX_IO_VARIABLES; i++) {
+    const IOVariable &io = config.ioVariables[i];
+    if (!io.status || io.type != Schedule) continue;
+    const schedule *window = findSchedule(config, io.num);
+    if (window == nullptr) {
+      addIssue(report, ISSUE_ERROR, "Schedule %u: no window", io.num);
+    } else if (!windowOpens(*window)) {
+      addIssue(report, ISSUE_WARNING, "Schedule %u: window never opens",
+               io.num);
+    }
+  }
+}
+// --- End IOVariable Checks ---
+
+// --- Reference Checks ---
+static void checkConditions(const configView &config,
+                            validationReport &report) {
+  for (logicId i = 0; i < MAX_CONDITIONS; i++) {
+    const condition &cond = config.conditions[i];
+    if (!cond.status) continue;
+    if (findCondition(config, cond.conNum) != &cond) {
+      addIssue(report, ISSUE_ERROR, "Condition %u: ID used twice",
+               cond.conNum);
+    }
+    if ((unsigned)cond.comp > flagIsFalse) {
+      addIssue(report, ISSUE_ERROR, "Condition %u: unknown comparison %d",
+               cond.conNum, cond.comp);
+    }
+    checkTarget(config, report, "Condition", cond.conNum, cond.Type,
+                cond.targetNum);
+  }
+}
+
+static void checkActions(const configView &config, validationReport &report) {
+  for (logicId i = 0; i < MAX_ACTIONS; i++) {
+    const action &act = config.actions[i];
+    if (!act.status) continue;
+    if (findAction(config, act.actNum) != &act) {
+      addIssue(report, ISSUE_ERROR, "Action %u: ID used twice", act.actNum);
+    }
+    if ((unsigned)act.action > clear) {
+      addIssue(report, ISSUE_ERROR, "Action %u: unknown action %d",
+               act.actNum, act.action);
+      continue;
+    }
+    int16_t slot = checkTarget(config, report, "Action", act.actNum,
+                               act.Type, act.targetNum);
+    if (slot < 0) continue;
+    dataTypes type = config.ioVariables[slot].type;
+    bool readOnly =
+        type == DigitalInput || type == AnalogInput || type == Schedule;
+    if (readOnly && act.action != setFlag && act.action != clear) {
+      addIssue(report, ISSUE_ERROR, "Action %u: %s %u is read-only",
+               act.actNum, typeNames[type], act.targetNum);
+    }
+  }
+}
+
+static void checkGroups(const configView &config, validationReport &report) {
+  for (logicId i = 0; i < MAX_CONDITION_GROUPS; i++) {
+    const conditionGroup &group = config.conditionGroups[i];
+    if (!group.status) continue;
+    if (findConditionGroup(config, group.num) != &group) {
+      addIssue(report, ISSUE_ERROR, "Condition group %u: ID used twice",
+               group.num);
+    }
+    if ((unsigned)group.Logic > orLogic) {
+      addIssue(report, ISSUE_ERROR, "Condition group %u: unknown logic %d",
+               group.num, group.Logic);
+    }
+    for (uint8_t j = 0; j < MAX_CONDITIONS_PER_GROUP; j++) {
+      logicId member = group.conditionArray[j];
+      if (member != 0 && findCondition(config, member) == nullptr) {
+        addIssue(report, ISSUE_ERROR,
+                 "Condition group %u: condition %u missing or disabled",
+                 group.num, member);
+      }
+    }
+  }
+  for (logicId i = 0; i < MAX_ACTION_GROUPS; i++) {
+    const actionGroup &group = config.actionGroups[i];
+    if (!group.status) continue;
+    if (findActionGroup(config, group.num) != &group) {
+      addIssue(report, ISSUE_ERROR, "Action group %u: ID used twice",
+               group.num);
+    }
+    for (uint8_t j = 0; j < MAX_ACTIONS_PER_GROUP; j++) {
+      logicId member = group.actionArray[j];
+      if (member != 0 && findAction(config, member) == nullptr) {
+        addIssue(report, ISSUE_ERROR,
+                 "Action group %u: action %u missing or disabled", group.num,
+                 member);
+      }
+    }
+  }
+}
+
+static void checkRules(const configView &config, validationReport &report) {
+  for (logicId i = 0; i < MAX_RULES; i++) {
+    const rule &ru = config.rules[i];
+    if (!ru.status) continue;
+    if (findRule(config, ru.num) != &ru) {
+      addIssue(report, ISSUE_ERROR, "Rule %u: ID used twice", ru.num);
+    }
+    bool source = ru.useConditionGroup
+                      ? findConditionGroup(config, ru.conditionSourceId)
+                      : (const void *)findCondition(config,
+                                                    ru.conditionSourceId);
+    if (!source) {
+      addIssue(report, ISSUE_ERROR, "Rule %u: %s %u missing or disabled",
+               ru.num, ru.useConditionGroup ? "condition group" : "condition",
+               ru.conditionSourceId);
+    }
+    bool target = ru.useActionGroup
+                      ? findActionGroup(config, ru.actionTargetId)
+                      : (const void *)findAction(config, ru.actionTargetId);
+    if (!target) {
+      addIssue(report, ISSUE_ERROR, "Rule %u: %s %u missing or disabled",
+               ru.num, ru.useActionGroup ? "action group" : "action",
+               ru.actionTargetId);
+    }
+  }
+
+  memset(scratch.sequenced, 0, sizeof(scratch.sequenced));
+  for (logicId s = 0; s < MAX_RULES; s++) {
+    logicId num = config.ruleSequence[s];
+    if (num == 0 || num > MAX_RULES) continue;
+    if (scratch.sequenced[num]) {
+      addIssue(report, ISSUE_ERROR, "Rule sequence: rule %u listed twice",
+               num);
+    }
+    scratch.sequenced[num] = true;
+  }
+}
+// --- End Reference Checks ---
+
+// --- Worst-Case Cost and Write Conflicts ---
+// Calls 'visit' with each condition a rule reads (the compiler's view:
+// unresolvable members are skipped)
+template <typename Visit>
+static void forEachCondition(const configView &config, const rule &ru,
+                             Visit visit) {
+  if (!ru.useConditionGroup) {
+    const condition *cond = findCondition(config, ru.conditionSourceId);
+    if (cond) visit(*cond);
+    return;
+  }
+  const conditionGroup *group =
+      findConditionGroup(config, ru.conditionSourceId);
+  if (!group) return;
+  for (uint8_t j = 0; j < MAX_CONDITIONS_PER_GROUP; j++) {
+    const condition *cond = findCondition(config, group->conditionArray[j]);
+    if (cond) visit(*cond);
+  }
+}
+
+template <typename Visit>
+static void forEachAction(const configView &config, const rule &ru,
+                          Visit visit) {
+  if (!ru.useActionGroup) {
+    const action *act = findAction(config, ru.actionTargetId);
+    if (act) visit(*act);
+    return;
+  }
+  const actionGroup *group = findActionGroup(config, ru.actionTargetId);
+  if (!group) return;
+  for (uint8_t j = 0; j < MAX_ACTIONS_PER_GROUP; j++) {
+    const action *act = findAction(config, group->actionArray[j]);
+    if (act) visit(*act);
+  }
+}
+
+static int16_t enabledSlot(const configView &config, dataTypes type,
+                           uint8_t num) {
+  int16_t slot = findSlot(config, type, num);
+  return (slot >= 0 && config.ioVariables[slot].status) ? slot : -1;
+}
+
+static writeField fieldOf(actionType effect) {
+  switch (effect) {
+    case setValue:
+    case increment:
+    case decrement:
+      return FIELD_VALUE;
+    case setFlag:
+    case clear:
+      return FIELD_FLAG;
+    default:
+      return FIELD_STATE;
+  }
+}
+
+// Warns once per field when two writes in one scan disagree; counting up
+// and down from several rules accumulates and is not a conflict
+static void noteWrite(const configView &config, validationReport &report,
+                      logicId ruleNum, const action &act, uint8_t slot) {
+  fieldWriter &writer = scratch.writers[slot][fieldOf(act.action)];
+  bool sameValue = act.action == setValue ? act.value == writer.value : true;
+  bool counting = (act.action == increment || act.action == decrement) &&
+                  (writer.effect == increment || writer.effect == decrement);
+  if (writer.ruleNum == 0) {
+    writer.ruleNum = ruleNum;
+    writer.effect = act.action;
+    writer.value = act.value;
+  } else if (!writer.reported && !counting &&
+             (writer.effect != act.action || !sameValue)) {
+    const IOVariable &io = config.ioVariables[slot];
+    if (writer.ruleNum == ruleNum) {
+      addIssue(report, ISSUE_WARNING, "Rule %u writes %s %u twice", ruleNum,
+               typeNames[io.type], io.num);
+    } else {
+      addIssue(report, ISSUE_WARNING, "Rules %u and %u both write %s %u",
+               writer.ruleNum, ruleNum, typeNames[io.type], io.num);
+    }
+    writer.reported = true;
+  }
+}
+
+static uint32_t actionCost(const IOVariable &io, const action &act) {
+  uint32_t cycles = WCET_ACTION;
+  bool armsTimer = io.type == Timer && (act.action == set ||
+                                        act.action == reset ||
+                                        act.action == clear);
+  armsTimer |= io.type == DigitalOutput &&
+               (io.mode == startDelay || io.mode == autoOff) &&
+               (act.action == set || act.action == reset);
+  if (armsTimer) cycles += WCET_TIMER;
+  return cycles;
+}
+
+static void analyzeProgram(const configView &config,
+                           validationReport &report) {
+  memset(scratch.slotReads, 0, sizeof(scratch.slotReads));
+  memset(scratch.writers, 0, sizeof(scratch.writers));
+  uint32_t cycles = WCET_SCAN_FIXED + WCET_OUTPUT_WRITE;
+
+  // Reads per slot: what a change of that slot invalidates
+  for (logicId i = 0; i < MAX_RULES; i++) {
+    const rule &ru = config.rules[i];
+    if (!ru.status) continue;
+    forEachCondition(config, ru, [&](const condition &cond) {
+      int16_t slot = enabledSlot(config, cond.Type, cond.targetNum);
+      if (slot >= 0) scratch.slotReads[slot]++;
+    });
+  }
+
+  // Latch, commit and external changes of every enabled slot
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    const IOVariable &io = config.ioVariables[i];
+    cycles += WCET_SLOT;
+    if (!io.status) continue;
+    if (io.type == DigitalInput) cycles += WCET_LATCH_DIGITAL;
+    if (io.type == AnalogInput) {
+      bool adc1 = io.gpio >= 32 && io.gpio <= 39;
+      cycles += adc1 ? WCET_LATCH_ANALOG : WCET_ANALOG_READ;
+    }
+    if (io.type == DigitalOutput) cycles += WCET_COMMIT_OUTPUT;
+    cycles += WCET_SLOT_CHANGE + WCET_DEPENDENCY * scratch.slotReads[i];
+  }
+
+  // Every rule evaluated and firing once, in sequence order
+  memset(scratch.sequenced, 0, sizeof(scratch.sequenced));
+  for (logicId s = 0; s < MAX_RULES; s++) {
+    const rule *ru = findRule(config, config.ruleSequence[s]);
+    if (!ru || scratch.sequenced[ru->num]) continue;
+    scratch.sequenced[ru->num] = true;
+    cycles += WCET_RULE;
+    forEachCondition(config, *ru, [&](const condition &cond) {
+      bool numeric =
+          cond.comp == isEqual || cond.comp == isLess || cond.comp == isGreater;
+      cycles += WCET_MASK_TEST +
+                (numeric ? WCET_CONDITION_NUMERIC : WCET_CONDITION_BOOL);
+    });
+    forEachAction(config, *ru, [&](const action &act) {
+      int16_t slot = enabledSlot(config, act.Type, act.targetNum);
+      if (slot < 0) return;
+      cycles += actionCost(config.ioVariables[slot], act) +
+                WCET_DEPENDENCY * scratch.slotReads[slot];
+      noteWrite(config, report, ru->num, act, slot);
+    });
+  }
+
+  report.worstCaseCycles = cycles;
+  uint8_t periodMs = config.device->scanPeriodMs;
+  report.budgetCycles =
+      (uint32_t)periodMs * 1000 * WCET_CPU_MHZ * SCAN_BUDGET_PERCENT / 100;
+  if (cycles > report.budgetCycles) {
+    addIssue(report, ISSUE_ERROR,
+             "Worst-case scan %u us exceeds %u us budget (%u ms period)",
+             (unsigned)(cycles / WCET_CPU_MHZ),
+             (unsigned)(report.budgetCycles / WCET_CPU_MHZ), periodMs);
+  }
+}
+// --- End Worst-Case Cost and Write Conflicts ---
+
+void validateConfig(const configView &config, validationReport &report) {
+  report.errors = 0;
+  report.warnings = 0;
+  report.stored = 0;
+  checkIOVariables(config, report);
+  checkSchedules(config, report);
+  checkConditions(config, report);
+  checkActions(config, report);
+  checkGroups(config, report);
+  checkRules(config, report);
+  analyzeProgram(config, report);
+}
+
+void recordValidation(const validationReport &report, bool applied) {
+  if (!applied) {
+    validatorStats.rejectedUploads++;
+    return;
+  }
+  validatorStats.worstCaseUs = report.worstCaseCycles / WCET_CPU_MHZ;
+  validatorStats.budgetUs = report.budgetCycles / WCET_CPU_MHZ;
+  validatorStats.warnings = report.warnings;
+}
+
+String validationText(const validationReport &report) {
+  String text;
+  char line[VALIDATION_MESSAGE_SIZE + 16];
+  for (uint8_t i = 0; i < report.stored; i++) {
+    const validationIssue &issue = report.issues[i];
+    snprintf(line, sizeof(line), "%s: %s\n",
+             issue.severity == ISSUE_ERROR ? "error" : "warning",
+             issue.message);
+    text += line;
+  }
+  uint16_t more = report.errors + report.warnings - report.stored;
+  if (more > 0) {
+    snprintf(line, sizeof(line), "(%u more)\n", more);
+    text += line;
+  }
+  snprintf(line, sizeof(line), "Worst-case scan %u us of %u us budget\n",
+           (unsigned)(report.worstCaseCycles / WCET_CPU_MHZ),
+           (unsigned)(report.budgetCycles / WCET_CPU_MHZ));
+  text += line;
+  return text;
+}
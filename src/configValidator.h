@@ -0,0 +1,79 @@
+#ifndef CONFIG_VALIDATOR_H
+#define CONFIG_VALIDATOR_H
+
+#include <Arduino.h>
+
+#include "configJson.h"
+
+// Static analysis of a configuration before it runs, shared by the firmware
+// (every upload, and the stored config at boot) and the host benchmark.
+//
+// Errors reject an upload: a reference from an enabled entity to something
+// missing or disabled, duplicate IDs or rule order entries, actions that
+// write a read-only input, out-of-range enum values, an IOVariable whose
+// type does not match its slot range, an enabled IOVariable with a mode
+// its type does not have, a pin that cannot serve its type (flash pins,
+// input-only pins as outputs, analog inputs without an ADC) or that another
+// enabled IOVariable already uses, an enabled Schedule without a window
+// or a window whose Schedule is missing or disabled, and a worst-case scan
+// cost over the budget. Two rules writing different values to the same
+// field in one scan only warn; the later rule in the sequence wins.
+//
+// The worst case assumes every input changes and every rule fires in the
+// same scan. Costs are CPU cycles per operation; compare the estimate with
+// the scan_exec_us histogram and per-rule cycles in /metrics to re-tune.
+
+#define SCAN_BUDGET_PERCENT 50  // Share of the scan period the logic may use
+#define WCET_CPU_MHZ 240
+
+#define WCET_SCAN_FIXED 6000       // Wake-up, statistics, scheduler peek
+#define WCET_SLOT 40               // Shadow compare and publish, every slot
+#define WCET_LATCH_DIGITAL 120     // digitalRead() and edge capture
+#define WCET_LATCH_ANALOG 200      // Filtered ADC1 reading
+#define WCET_ANALOG_READ 12000     // analogRead() outside ADC1
+#define WCET_COMMIT_OUTPUT 30      // Compare and set/clear mask update
+#define WCET_OUTPUT_WRITE 40       // GPIO set/clear register writes
+#define WCET_SLOT_CHANGE 300       // Event record and dirty marking
+#define WCET_DEPENDENCY 12         // Per condition/rule invalidated
+#define WCET_RULE 250              // Dirty check, profiling, EDGE, JMPF
+#define WCET_MASK_TEST 20          // Per condition word read
+#define WCET_CONDITION_BOOL 30     // State or flag sample
+#define WCET_CONDITION_NUMERIC 45  // Value comparison
+#define WCET_ACTION 300            // Write with event record
+#define WCET_TIMER 1500            // esp_timer start or stop
+
+#define VALIDATION_MAX_ISSUES 8  // Kept with their text; the rest counted
+#define VALIDATION_MESSAGE_SIZE 64
+
+enum issueSeverity : uint8_t { ISSUE_WARNING, ISSUE_ERROR };
+
+struct validationIssue {
+  issueSeverity severity;
+  char message[VALIDATION_MESSAGE_SIZE];
+};
+
+struct validationReport {
+  uint16_t errors;
+  uint16_t warnings;
+  uint8_t stored;  // Entries used in issues[]
+  validationIssue issues[VALIDATION_MAX_ISSUES];
+  uint32_t worstCaseCycles;
+  uint32_t budgetCycles;
+};
+
+struct validatorStatistics {
+  uint32_t worstCaseUs;  // Estimate for the active configuration
+  uint32_t budgetUs;
+  uint16_t warnings;         // Of the active configuration
+  uint32_t rejectedUploads;  // Since boot
+};
+
+extern validatorStatistics validatorStats;
+
+void validateConfig(const configView &config, validationReport &report);
+// The configuration of 'report' became active, or an upload was refused
+void recordValidation(const validationReport &report, bool applied);
+// Stored issues, one per line, then the cost estimate
+String validationText(const validationReport &report);
+
+#endif  // CONFIG_VALIDATOR_H
@@ -3,96 +3,54 @@
 #include <stdio.h>
 
 // === Define Global Arrays (matching extern declarations in .h) ===
-IOVariable IOVariables[MAX_DIGITAL_IN + MAX_DIGITAL_OUT + MAX_ANALOG_IN +
-                       MAX_SOFTIO + MAX_TIMERS];
+static IOVariable ioImages[2][MAX_IO_VARIABLES];
+IOVariable *IOVariables = ioImages[0];
 condition conditions[MAX_CONDITIONS];
 conditionGroup conditionGroups[MAX_CONDITION_GROUPS];
 action actions[MAX_ACTIONS];
 actionGroup actionGroups[MAX_ACTION_GROUPS];
 rule rules[MAX_RULES];
-uint8_t ruleSequence[MAX_RULES];
+logicId ruleSequence[MAX_RULES];
+schedule schedules[MAX_SCHEDULES];
 // ==============================================================
 
+// Fills 'count' slots from 'first' with disabled IOVariables of one type
+static void createDefaults(uint8_t first, uint8_t count, dataTypes type,
+                           operationMode mode, const uint8_t *gpios,
+                           const char *label) {
+  for (uint8_t i = 0; i < count; i++) {
+    IOVariable &io = IOVariables[first + i];
+    io.num = i + 1;
+    io.gpio = gpios != nullptr ? gpios[i] : 0;
+    io.type = type;
+    io.mode = mode;
+    snprintf(io.name, sizeof(io.name), "%s %d", label, i + 1);
+    io.state = false;
+    io.value = 0;
+    io.flag = false;
+    io.status = false;
+  }
+}
+
 // Create a default Map for initial population if config doesn't exist
 void CreateDefaultIOVariables() {
-  uint8_t DI_GPIO[] = {4, 2, 15, 13, 12, 14};
-  uint8_t DO_GPIO[] = {27, 26, 25, 33};
-  uint8_t AI_GPIO[] = {35, 34, 39, 36};
-  uint8_t DI_First = 0;
-  uint8_t DI_Last = MAX_DIGITAL_IN - 1;
-  uint8_t DO_First = DI_Last + 1;
-  uint8_t DO_Last = DO_First + MAX_DIGITAL_OUT - 1;
-  uint8_t AI_First = DO_Last + 1;
-  uint8_t AI_Last = AI_First + MAX_ANALOG_IN - 1;
-  uint8_t SoftIO_First = AI_Last + 1;
-  uint8_t SoftIO_Last = SoftIO_First + MAX_SOFTIO - 1;
-  uint8_t Timer_First = SoftIO_Last + 1;
-  uint8_t Timer_Last = Timer_First + MAX_TIMERS - 1;
-  for (uint8_t i = 0; i < MAX_DIGITAL_IN; i++) {
-    IOVariables[i].num = i + 1;
-    IOVariables[i].gpio = DI_GPIO[i];
-    IOVariables[i].type = DigitalInput;
-    IOVariables[i].mode = none;
-    snprintf(IOVariables[i].name, sizeof(IOVariables[i].name),
-             "Digital Input %d", i + 1);
-    IOVariables[i].state = false;
-    IOVariables[i].value = 0;
-    IOVariables[i].flag = false;
-    IOVariables[i].status = false;
-  }
-  for (uint8_t i = 0; i < MAX_DIGITAL_OUT; i++) {
-    IOVariables[i + DO_First].num = i + 1;
-    IOVariables[i + DO_First].gpio = DO_GPIO[i];
-    IOVariables[i + DO_First].type = DigitalOutput;
-    IOVariables[i + DO_First].mode = none;
-    snprintf(IOVariables[i + DO_First].name,
-             sizeof(IOVariables[i + DO_First].name), "Digital Output %d",
-             i + 1);
-    IOVariables[i + DO_First].state = false;
-    IOVariables[i + DO_First].value = 0;
-    IOVariables[i + DO_First].flag = false;
-    IOVariables[i + DO_First].status = false;
-  }
-  for (uint8_t i = 0; i < MAX_ANALOG_IN; i++) {
-    IOVariables[i + AI_First].num = i + 1;
-    IOVariables[i + AI_First].gpio = AI_GPIO[i];
-    IOVariables[i + AI_First].type = AnalogInput;
-    IOVariables[i + AI_First].mode = none;
-    snprintf(IOVariables[i + AI_First].name,
-             sizeof(IOVariables[i + AI_First].name), "Analog Input %d", i + 1);
-    IOVariables[i + AI_First].state = false;
-    IOVariables[i + AI_First].value = 0;
-    IOVariables[i + AI_First].flag = false;
-    IOVariables[i + AI_First].status = false;
-  }
-  for (uint8_t i = 0; i < MAX_SOFTIO; i++) {
-    IOVariables[i + SoftIO_First].num = i + 1;
-    IOVariables[i + SoftIO_First].gpio = 0;
-    IOVariables[i + SoftIO_First].type = SoftIO;
-    IOVariables[i + SoftIO_First].mode = none;
-    snprintf(IOVariables[i + SoftIO_First].name,
-             sizeof(IOVariables[i + SoftIO_First].name), "Soft IO %d", i + 1);
-    IOVariables[i + SoftIO_First].state = false;
-    IOVariables[i + SoftIO_First].value = 0;
-    IOVariables[i + SoftIO_First].flag = false;
-    IOVariables[i + SoftIO_First].status = false;
-  }
-  for (uint8_t i = 0; i < MAX_TIMERS; i++) {
-    IOVariables[i + Timer_First].num = i + 1;
-    IOVariables[i + Timer_First].gpio = 0;
-    IOVariables[i + Timer_First].type = Timer;
-    IOVariables[i + Timer_First].mode = oneShot;
-    snprintf(IOVariables[i + Timer_First].name,
-             sizeof(IOVariables[i + Timer_First].name), "Timer %d", i + 1);
-    IOVariables[i + Timer_First].state = false;
-    IOVariables[i + Timer_First].value = 0;
-    IOVariables[i + Timer_First].flag = false;
-    IOVariables[i + Timer_First].status = false;
-  }
+  static const uint8_t DI_GPIO[MAX_DIGITAL_IN] = {4, 2, 15, 13, 12, 14};
+  static const uint8_t DO_GPIO[MAX_DIGITAL_OUT] = {27, 26, 25, 33};
+  static const uint8_t AI_GPIO[MAX_ANALOG_IN] = {35, 34, 39, 36};
+  createDefaults(FIRST_DIGITAL_IN, MAX_DIGITAL_IN, DigitalInput, none,
+                 DI_GPIO, "Digital Input");
+  createDefaults(FIRST_DIGITAL_OUT, MAX_DIGITAL_OUT, DigitalOutput, none,
+                 DO_GPIO, "Digital Output");
+  createDefaults(FIRST_ANALOG_IN, MAX_ANALOG_IN, AnalogInput, none, AI_GPIO,
+                 "Analog Input");
+  createDefaults(FIRST_SOFTIO, MAX_SOFTIO, SoftIO, none, nullptr, "Soft IO");
+  createDefaults(FIRST_TIMER, MAX_TIMERS, Timer, oneShot, nullptr, "Timer");
+  createDefaults(FIRST_SCHEDULE, MAX_SCHEDULES, Schedule, none, nullptr,
+                 "Schedule");
 }
 
 void InitializeDefaultLogicComponents() {
-  for (uint8_t i = 0; i < MAX_CONDITIONS; i++) {
+  for (logicId i = 0; i < MAX_CONDITIONS; i++) {
     conditions[i].conNum = i + 1;
     conditions[i].Type = SoftIO;
     conditions[i].targetNum = 0;
@@ -100,7 +58,7 @@ void InitializeDefaultLogicComponents() {
     conditions[i].value = 0;
     conditions[i].status = false;
   }
-  for (uint8_t i = 0; i < MAX_CONDITION_GROUPS; i++) {
+  for (logicId i = 0; i < MAX_CONDITION_GROUPS; i++) {
     conditionGroups[i].num = i + 1;
     for (uint8_t j = 0; j < MAX_CONDITIONS_PER_GROUP; j++) {
       conditionGroups[i].conditionArray[j] = 0;
@@ -108,7 +66,7 @@ void InitializeDefaultLogicComponents() {
     conditionGroups[i].Logic = andLogic;
     conditionGroups[i].status = false;
   }
-  for (uint8_t i = 0; i < MAX_ACTIONS; i++) {
+  for (logicId i = 0; i < MAX_ACTIONS; i++) {
     actions[i].actNum = i + 1;
     actions[i].Type = SoftIO;
     actions[i].targetNum = 0;
@@ -116,7 +74,7 @@ void InitializeDefaultLogicComponents() {
     actions[i].value = 0;
     actions[i].status = false;
   }
-  for (uint8_t i = 0; i < MAX_ACTION_GROUPS; i++) {
+  for (logicId i = 0; i < MAX_ACTION_GROUPS; i++) {
     actionGroups[i].num = i + 1;
     for (uint8_t j = 0; j < MAX_ACTIONS_PER_GROUP; j++) {
       actionGroups[i].actionArray[j] = 0;
@@ -134,4 +92,24 @@ void InitializeDefaultLogicComponents() {
   for (uint8_t i = 0; i < MAX_RULES; i++) {
     ruleSequence[i] = i + 1;
   }
+  for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+    schedules[i].num = i + 1;
+    schedules[i].days = 0x7F;  // Every day
+    schedules[i].onMinute = 0;
+    schedules[i].offMinute = 0;
+  }
+}
+
+IOVariable *spareIOVariables() {
+  return IOVariables == ioImages[0] ? ioImages[1] : ioImages[0];
+}
+
+int16_t findIOVariableSlot(dataTypes type, uint8_t num,
+                           const IOVariable *image) {
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    if (image[i].type == type && image[i].num == num) {
+      return i;
+    }
+  }
+  return -1;
 }
@@ -2,25 +2,39 @@
 #define DATA_STRUCTURE_H
 
 #include <Arduino.h>
-#include <ArduinoJson.h>  // Include ArduinoJson for types used in function signatures
 
-// Define maximum number of variables and logic elements
+#include "capacityProfile.h"  // Logic limits and ID width of this build
+
+// Physical IO counts follow the board's GPIO map; the other limits come from
+// the capacity profile
 #define MAX_DIGITAL_IN 6
 #define MAX_DIGITAL_OUT 4
 #define MAX_ANALOG_IN 4
-#define MAX_SOFTIO 5
-#define MAX_TIMERS 5
-#define MAX_CONDITIONS 50
-#define MAX_CONDITION_GROUPS 20
-#define MAX_ACTIONS 50
-#define MAX_ACTION_GROUPS 20
-#define MAX_RULES 20
-#define MAX_CONDITIONS_PER_GROUP 10
-#define MAX_ACTIONS_PER_GROUP 10
+#define MAX_IO_VARIABLES                                          \
+  (MAX_DIGITAL_IN + MAX_DIGITAL_OUT + MAX_ANALOG_IN + MAX_SOFTIO + \
+   MAX_TIMERS + MAX_SCHEDULES)
+
+// First IOVariables[] slot of each type in the default map
+constexpr uint8_t FIRST_DIGITAL_IN = 0;
+constexpr uint8_t FIRST_DIGITAL_OUT = FIRST_DIGITAL_IN + MAX_DIGITAL_IN;
+constexpr uint8_t FIRST_ANALOG_IN = FIRST_DIGITAL_OUT + MAX_DIGITAL_OUT;
+constexpr uint8_t FIRST_SOFTIO = FIRST_ANALOG_IN + MAX_ANALOG_IN;
+constexpr uint8_t FIRST_TIMER = FIRST_SOFTIO + MAX_SOFTIO;
+constexpr uint8_t FIRST_SCHEDULE = FIRST_TIMER + MAX_TIMERS;
+static_assert(FIRST_SCHEDULE + MAX_SCHEDULES == MAX_IO_VARIABLES,
+              "Every IOVariables[] slot belongs to one type");
+static_assert(MAX_IO_VARIABLES <= 255, "IO slots are 8-bit");
 
 // --- Enums ---
 // Defines the different types of I/O or internal variables
-enum dataTypes { DigitalInput, DigitalOutput, AnalogInput, SoftIO, Timer };
+enum dataTypes {
+  DigitalInput,
+  DigitalOutput,
+  AnalogInput,
+  SoftIO,
+  Timer,
+  Schedule  // State is true inside its calendar window (see schedules[])
+};
 
 // Defines operational modes, primarily for Digital Inputs and Timers
 enum operationMode {
@@ -86,7 +100,7 @@ struct IOVariable {
 
 // Represents a single condition to be evaluated
 struct condition {
-  uint8_t conNum;     // Unique ID for this condition
+  logicId conNum;     // Unique ID for this condition, 1..MAX_CONDITIONS
   dataTypes Type;     // Type of the target IOVariable to check
   uint8_t targetNum;  // 'num' of the target IOVariable to check
   comparisons comp;   // Comparison operation to perform
@@ -96,7 +110,7 @@ struct condition {
 
 // Represents a single action to be performed
 struct action {
-  uint8_t actNum;     // Unique ID for this action
+  logicId actNum;     // Unique ID for this action, 1..MAX_ACTIONS
   dataTypes Type;     // Type of the target IOVariable to affect
   uint8_t targetNum;  // 'num' of the target IOVariable to affect
   actionType action;  // Action to perform (e.g., set, setValue)
@@ -106,48 +120,64 @@ struct action {
 
 // Groups multiple conditions together with a combining logic
 struct conditionGroup {
-  uint8_t num;  // Unique ID for this group
-  uint8_t conditionArray[MAX_CONDITIONS_PER_GROUP];
+  logicId num;  // Unique ID for this group
+  logicId conditionArray[MAX_CONDITIONS_PER_GROUP];  // 'conNum's, 0 = unused
   combineLogic Logic;  // Logic used to combine results (AND/OR)
   bool status;         // Is this group definition active/enabled?
 };
 
 // Groups multiple actions together to be executed sequentially
 struct actionGroup {
-  uint8_t num;                                 // Unique ID for this group
-  uint8_t actionArray[MAX_ACTIONS_PER_GROUP];  // Array of 'actNum's
+  logicId num;                                 // Unique ID for this group
+  logicId actionArray[MAX_ACTIONS_PER_GROUP];  // Array of 'actNum's
   bool status;  // Is this group definition active/enabled?
 };
 
 // Represents a rule linking a Condition Source (Group or Single) to an Action
 // Target (Group or Single)
 struct rule {
-  uint8_t num;                // Unique ID for this rule
+  logicId num;                // Unique ID for this rule
   bool useConditionGroup;     // true: use group, false: use single condition
-  uint8_t conditionSourceId;  // Holds either conditionGroup OR condition
+  logicId conditionSourceId;  // Holds either conditionGroup OR condition
   bool useActionGroup;     // Flag: true = use group, false = use single action
-  uint8_t actionTargetId;  // Holds either actionGroup 'num' OR action 'actNum'
+  logicId actionTargetId;  // Holds either actionGroup 'num' OR action 'actNum'
   bool status;             // Is this rule definition active/enabled?
 };
 
+// Calendar window of the Schedule IOVariable with the same 'num'. The window
+// opens at onMinute on each selected weekday and closes at offMinute; an
+// offMinute before onMinute closes on the next day, equal means never open.
+struct schedule {
+  uint8_t num;         // 'num' of the Schedule IOVariable
+  uint8_t days;        // Weekday mask, bit 0 = Sunday ... bit 6 = Saturday
+  uint16_t onMinute;   // Local minute of the day, 0-1439
+  uint16_t offMinute;  // Local minute of the day, 0-1439
+};
+
 // --- End Struct Definitions ---
 
 // --- Extern Declarations for Global Data Arrays ---
 // These arrays hold the actual configuration and runtime state data.
 // They are defined in dataStructure.cpp.
 
-extern IOVariable IOVariables[MAX_DIGITAL_IN + MAX_DIGITAL_OUT + MAX_ANALOG_IN +
-                              MAX_SOFTIO + MAX_TIMERS];
+// IOVariables points at the active one of two images. A new configuration is
+// written to the spare image and the scan task switches over between scans.
+extern IOVariable *IOVariables;
 extern condition conditions[MAX_CONDITIONS];
 extern conditionGroup conditionGroups[MAX_CONDITION_GROUPS];
 extern action actions[MAX_ACTIONS];
 extern actionGroup actionGroups[MAX_ACTION_GROUPS];
 extern rule rules[MAX_RULES];
-extern uint8_t ruleSequence[MAX_RULES];  // Defines the order in which active
+extern logicId ruleSequence[MAX_RULES];  // Defines the order in which active
                                          // rules are evaluated
+extern schedule schedules[MAX_SCHEDULES];
 // --- End Extern Declarations ---
 
 void CreateDefaultIOVariables();
 void InitializeDefaultLogicComponents();
+IOVariable *spareIOVariables();  // The image the scan task is not using
+// Returns the slot holding (type, num) in 'image', or -1 if none exists
+int16_t findIOVariableSlot(dataTypes type, uint8_t num,
+                           const IOVariable *image = IOVariables);
 
 #endif  // DATA_STRUCTURE_H
@@ -0,0 +1,258 @@
+#include "eventRecorder.h"
+
+#include <LittleFS.h>
+#include <esp_timer.h>
+
+#include <atomic>
+#include <memory>
+
+#define EVENT_FILE_SIZE (EVENT_PAGE_SIZE * EVENT_FILE_PAGES)
+#define EVENT_PATH_SIZE 24
+
+struct eventDownloadHeader {
+  uint32_t magic;
+  uint16_t recordSize;
+  uint16_t tailRecords;  // Records from RAM at the end of the download
+  uint32_t timeLow;      // esp_timer clock when the download started
+  uint32_t timeHigh;
+};
+
+eventRecorderStatistics eventRecorderStats;
+
+static TaskHandle_t eventTask = NULL;
+static File eventFile;
+
+// Shared with downloads, guarded by recorderLock. Records below pageFill
+// are final until the page is written out, which bumps pageGeneration; the
+// task only writes page[] beyond pageFill outside the lock.
+static portMUX_TYPE recorderLock = portMUX_INITIALIZER_UNLOCKED;
+static eventRecord page[EVENT_PAGE_RECORDS];
+static uint16_t pageFill = 0;
+static uint32_t pageGeneration = 0;
+static uint32_t oldestFile = 0;  // Numbers of the files on flash
+static uint32_t newestFile = 0;
+static uint32_t newestSize = 0;  // Bytes in the newest file
+
+static void eventFilePath(char *path, uint32_t number) {
+  snprintf(path, EVENT_PATH_SIZE, EVENT_DIR "/%lu.bin",
+           (unsigned long)number);
+}
+
+// --- Recorder Task ---
+static bool openNewestFile(const char *mode) {
+  char path[EVENT_PATH_SIZE];
+  eventFilePath(path, newestFile);
+  eventFile = LittleFS.open(path, mode);
+  return (bool)eventFile;
+}
+
+static void rotateFile() {
+  eventFile.close();
+  uint32_t next = newestFile + 1;
+  uint32_t oldest = oldestFile;
+  while (next - oldest >= EVENT_FILE_COUNT) {
+    char path[EVENT_PATH_SIZE];
+    eventFilePath(path, oldest++);
+    LittleFS.remove(path);
+  }
+  portENTER_CRITICAL(&recorderLock);
+  oldestFile = oldest;
+  newestFile = next;
+  newestSize = 0;
+  portEXIT_CRITICAL(&recorderLock);
+  openNewestFile(FILE_WRITE);
+}
+
+static void writePage() {
+  if (newestSize >= EVENT_FILE_SIZE) rotateFile();
+  int64_t startUs = esp_timer_get_time();
+  bool ok = eventFile &&
+            eventFile.write((const uint8_t *)page, EVENT_PAGE_SIZE) ==
+                EVENT_PAGE_SIZE;
+  if (ok) eventFile.flush();  // Commit the page, not just buffer it
+  uint32_t us = (uint32_t)(esp_timer_get_time() - startUs);
+  eventRecorderStats.lastPageWriteUs = us;
+  if (us > eventRecorderStats.maxPageWriteUs) {
+    eventRecorderStats.maxPageWriteUs = us;
+  }
+  if (ok) {
+    eventRecorderStats.pagesWritten++;
+  } else {
+    eventRecorderStats.writeFailures++;  // Page dropped, keep recording
+  }
+  portENTER_CRITICAL(&recorderLock);
+  if (ok) newestSize += EVENT_PAGE_SIZE;
+  pageFill = 0;
+  pageGeneration++;
+  portEXIT_CRITICAL(&recorderLock);
+}
+
+static void eventTaskFunction(void *pvParameters) {
+  for (;;) {
+    uint16_t taken =
+        takeEvents(&page[pageFill], EVENT_PAGE_RECORDS - pageFill);
+    if (taken > 0) {
+      portENTER_CRITICAL(&recorderLock);
+      pageFill += taken;
+      portEXIT_CRITICAL(&recorderLock);
+    }
+    if (pageFill == EVENT_PAGE_RECORDS) {
+      writePage();
+      continue;  // The ring may hold more than one page
+    }
+    vTaskDelay(pdMS_TO_TICKS(EVENT_DRAIN_MS));
+  }
+}
+
+// Finds the numbered files left by earlier boots
+static void scanEventFiles() {
+  bool found = false;
+  uint32_t lowest = 0;
+  uint32_t highest = 0;
+  File dir = LittleFS.open(EVENT_DIR);
+  for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+    uint32_t number = strtoul(file.name(), nullptr, 10);
+    if (!found || number < lowest) lowest = number;
+    if (!found || number > highest) highest = number;
+    found = true;
+  }
+  oldestFile = lowest;
+  newestFile = highest;
+  newestSize = 0;
+  if (found) {
+    char path[EVENT_PATH_SIZE];
+    eventFilePath(path, newestFile);
+    File newest = LittleFS.open(path, FILE_READ);
+    newestSize = newest ? newest.size() : 0;
+  }
+}
+// --- End Recorder Task ---
+
+void startEventRecorder() {
+  if (eventTask != NULL) return;
+  if (!LittleFS.exists(EVENT_DIR)) LittleFS.mkdir(EVENT_DIR);
+  scanEventFiles();
+  if (newestSize % EVENT_PAGE_SIZE != 0) {
+    newestSize = EVENT_FILE_SIZE;  // Damaged tail: start the next file
+  }
+  if (newestSize >= EVENT_FILE_SIZE) {
+    rotateFile();
+  } else {
+    openNewestFile(FILE_APPEND);
+  }
+  Serial.printf("Event recorder: files %lu-%lu\n", (unsigned long)oldestFile,
+                (unsigned long)newestFile);
+  xTaskCreatePinnedToCore(eventTaskFunction, "eventTask", EVENT_TASK_STACK,
+                          NULL, EVENT_TASK_PRIORITY, &eventTask,
+                          EVENT_TASK_CORE);
+}
+
+// --- Download ---
+static std::atomic<uint8_t> activeDownloads(0);
+
+// Files and the RAM page as they were when the download started
+class eventDownload {
+ public:
+  eventDownload() {
+    // The page is copied outside the lock; if it was written out meanwhile
+    // the copy may be torn, so take a new snapshot
+    bool stable;
+    do {
+      portENTER_CRITICAL(&recorderLock);
+      uint32_t generation = pageGeneration;
+      file = oldestFile;
+      lastFile = newestFile;
+      lastSize = newestSize;
+      tailLength = pageFill * sizeof(eventRecord);
+      portEXIT_CRITICAL(&recorderLock);
+      memcpy(tail, page, tailLength);
+      portENTER_CRITICAL(&recorderLock);
+      stable = generation == pageGeneration;
+      portEXIT_CRITICAL(&recorderLock);
+    } while (!stable);
+
+    uint64_t nowUs = esp_timer_get_time();
+    header.magic = EVENT_MAGIC;
+    header.recordSize = sizeof(eventRecord);
+    header.tailRecords = tailLength / sizeof(eventRecord);
+    header.timeLow = (uint32_t)nowUs;
+    header.timeHigh = (uint32_t)(nowUs >> 32);
+  }
+
+  ~eventDownload() { activeDownloads--; }
+
+  size_t read(uint8_t *buffer, size_t maxLen) {
+    if (headerPos < sizeof(header)) {
+      size_t n = sizeof(header) - headerPos;
+      if (n > maxLen) n = maxLen;
+      memcpy(buffer, (const uint8_t *)&header + headerPos, n);
+      headerPos += n;
+      return n;
+    }
+    while (file <= lastFile) {
+      if (!current) {
+        char path[EVENT_PATH_SIZE];
+        eventFilePath(path, file);
+        current = LittleFS.open(path, FILE_READ);
+        filePos = 0;
+      }
+      // The newest file only up to its size at the start: later pages
+      // are still in 'tail'
+      uint32_t limit = (file == lastFile) ? lastSize : UINT32_MAX;
+      size_t n = 0;
+      if (current && filePos < limit) {
+        size_t wanted = maxLen;
+        if (wanted > limit - filePos) wanted = limit - filePos;
+        n = current.read(buffer, wanted);
+      }
+      if (n > 0) {
+        filePos += n;
+        return n;
+      }
+      current.close();  // Done, or rotated away meanwhile
+      current = File();
+      file++;
+    }
+    if (tailPos < tailLength) {
+      size_t n = tailLength - tailPos;
+      if (n > maxLen) n = maxLen;
+      memcpy(buffer, (const uint8_t *)tail + tailPos, n);
+      tailPos += n;
+      return n;
+    }
+    return 0;
+  }
+
+ private:
+  eventDownloadHeader header;
+  size_t headerPos = 0;
+  uint32_t file;
+  uint32_t lastFile;
+  uint32_t lastSize;
+  File current;
+  uint32_t filePos = 0;
+  eventRecord tail[EVENT_PAGE_RECORDS];
+  size_t tailLength;
+  size_t tailPos = 0;
+};
+
+void setupEventDownload(AsyncWebServer &server) {
+  server.on(EVENT_DOWNLOAD_PATH, HTTP_GET, [](AsyncWebServerRequest *request) {
+    if (activeDownloads++ >= EVENT_MAX_DOWNLOADS) {
+      activeDownloads--;
+      request->send(503, "text/plain", "Too many event downloads");
+      return;
+    }
+    std::shared_ptr<eventDownload> download =
+        std::make_shared<eventDownload>();  // Gives the slot back when done
+    AsyncWebServerResponse *response = request->beginChunkedResponse(
+        "application/octet-stream",
+        [download](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+          return download->read(buffer, maxLen);
+        });
+    response->addHeader("Content-Disposition",
+                        "attachment; filename=\"events.bin\"");
+    request->send(response);
+  });
+}
+// --- End Download ---
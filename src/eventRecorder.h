@@ -0,0 +1,54 @@
+#ifndef EVENT_RECORDER_H
+#define EVENT_RECORDER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#include "eventRing.h"
+
+// Persists the event ring to LittleFS. A low-priority task drains the ring
+// into a RAM page and appends only whole pages, so flash sees one aligned
+// EVENT_PAGE_SIZE write per EVENT_PAGE_RECORDS events however fast they
+// come. Pages go to numbered files in EVENT_DIR; once a file is full the
+// next number is started and the oldest beyond EVENT_FILE_COUNT is removed.
+// The page still in RAM is lost on power failure but included in downloads.
+//
+// Flash write rate: one page per 256 events. AnalogInputs add at most one
+// event per second each (ANALOG_EVENT_INTERVAL_MS), so with MAX_ANALOG_IN
+// noisy inputs they cost at most a page every 64 s and nothing while their
+// readings stay within the deadband. Digital and SoftIO changes are
+// recorded as they happen: a signal changing on every 10 ms scan fills a
+// page every 2.6 s, so rules should not drive such signals continuously.
+//
+// GET /events streams everything recorded, oldest first, as a 16-byte
+// header (magic "AEV1", uint16 record size, uint16 records still in RAM,
+// uint32 esp_timer µs low word, uint32 high word) followed by eventRecords.
+// Beyond EVENT_MAX_DOWNLOADS at once it answers 503.
+
+#define EVENT_DIR "/events"
+#define EVENT_DOWNLOAD_PATH "/events"
+#define EVENT_PAGE_SIZE 4096  // LittleFS block size
+#define EVENT_PAGE_RECORDS (EVENT_PAGE_SIZE / sizeof(eventRecord))
+#define EVENT_FILE_PAGES 16   // 64 KB per file
+#define EVENT_FILE_COUNT 4    // Files kept, 256 KB of flash in total
+#define EVENT_DRAIN_MS 20     // Ring drain period
+#define EVENT_MAGIC 0x31564541  // "AEV1"
+#define EVENT_MAX_DOWNLOADS 2  // Concurrent /events downloads, 4 KB each
+
+#define EVENT_TASK_CORE 0
+#define EVENT_TASK_PRIORITY 1
+#define EVENT_TASK_STACK 4096
+
+struct eventRecorderStatistics {
+  uint32_t pagesWritten;
+  uint32_t writeFailures;
+  uint32_t lastPageWriteUs;
+  uint32_t maxPageWriteUs;
+};
+
+extern eventRecorderStatistics eventRecorderStats;
+
+void startEventRecorder();  // After LittleFS is mounted
+void setupEventDownload(AsyncWebServer &server);
+
+#endif  // EVENT_RECORDER_H
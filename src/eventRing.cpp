@@ -0,0 +1,55 @@
+#include "eventRing.h"
+
+#include <atomic>
+
+eventRingStatistics eventRingStats;
+
+static eventRecord ring[EVENT_RING_SIZE];
+static std::atomic<uint32_t> ringHead(0);  // Next write, producer only
+static std::atomic<uint32_t> ringTail(0);  // Next read, consumer only
+static uint32_t eventTimeUs = 0;
+static uint32_t eventTimeHigh = 0;
+static bool bootRecorded = false;
+
+void setEventTime(uint64_t nowUs) {
+  eventTimeUs = (uint32_t)nowUs;
+  uint32_t high = (uint32_t)(nowUs >> 32);
+  if (!bootRecorded) {
+    bootRecorded = true;
+    eventTimeHigh = high;
+    recordEvent(EVENT_BOOT, EVENT_NO_SLOT, 0, 0, high);
+  } else if (high != eventTimeHigh) {
+    eventTimeHigh = high;
+    recordEvent(EVENT_CLOCK, EVENT_NO_SLOT, 0, 0, high);
+  }
+}
+
+void recordEvent(eventKind kind, uint8_t slot, uint8_t ruleNum,
+                 int32_t oldValue, int32_t newValue) {
+  uint32_t head = ringHead.load(std::memory_order_relaxed);
+  if (head - ringTail.load(std::memory_order_acquire) >= EVENT_RING_SIZE) {
+    eventRingStats.dropped++;
+    return;
+  }
+  eventRecord &record = ring[head & (EVENT_RING_SIZE - 1)];
+  record.timeUs = eventTimeUs;
+  record.kind = kind;
+  record.slot = slot;
+  record.ruleNum = ruleNum;
+  record.reserved = 0;
+  record.oldValue = oldValue;
+  record.newValue = newValue;
+  ringHead.store(head + 1, std::memory_order_release);
+  eventRingStats.recorded++;
+}
+
+uint16_t takeEvents(eventRecord *out, uint16_t max) {
+  uint32_t tail = ringTail.load(std::memory_order_relaxed);
+  uint32_t available = ringHead.load(std::memory_order_acquire) - tail;
+  uint16_t count = available < max ? available : max;
+  for (uint16_t i = 0; i < count; i++) {
+    out[i] = ring[(tail + i) & (EVENT_RING_SIZE - 1)];
+  }
+  ringTail.store(tail + count, std::memory_order_release);
+  return count;
+}
@@ -0,0 +1,54 @@
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <Arduino.h>
+
+// Fixed-size binary event records in a lock-free single-producer ring. The
+// scan task (rule engine) is the only producer; the event recorder task is
+// the only consumer. A full ring drops new events and counts them, so the
+// producer never waits.
+
+#ifndef EVENT_RING_SIZE
+#define EVENT_RING_SIZE 1024  // Records, power of two (16 KB)
+#endif
+
+#define EVENT_NO_SLOT 0xFF
+
+enum eventKind : uint8_t {
+  EVENT_BOOT,    // First record after boot, newValue = high time word
+  EVENT_CLOCK,   // Time wrapped, newValue = new high word of the µs clock
+  EVENT_STATE,   // IOVariables[slot].state changed
+  EVENT_VALUE,   // IOVariables[slot].value changed
+  EVENT_FLAG,    // IOVariables[slot].flag changed
+  EVENT_RULE,    // Rule ruleNum fired (rising edge of its condition)
+  EVENT_CONFIG,  // New configuration image, newValue = swap count
+};
+
+// 16 bytes, little-endian, written to flash and downloaded as is
+struct eventRecord {
+  uint32_t timeUs;   // Low word of the esp_timer clock at the scan start
+  eventKind kind;
+  uint8_t slot;      // IOVariables[] index or EVENT_NO_SLOT
+  uint8_t ruleNum;   // Rule whose action made the change, 0 = none
+  uint8_t reserved;
+  int32_t oldValue;
+  int32_t newValue;
+};
+
+struct eventRingStatistics {
+  uint32_t recorded;  // Events put in the ring
+  uint32_t dropped;   // Events lost because the ring was full
+};
+
+extern eventRingStatistics eventRingStats;
+
+// Sets the timestamp of the following events (scan task, once per cycle)
+void setEventTime(uint64_t nowUs);
+
+void recordEvent(eventKind kind, uint8_t slot, uint8_t ruleNum,
+                 int32_t oldValue, int32_t newValue);
+
+// Moves up to 'max' of the oldest events to 'out' (consumer only)
+uint16_t takeEvents(eventRecord *out, uint16_t max);
+
+#endif  // EVENT_RING_H
@@ -0,0 +1,78 @@
+#include "inputCapture.h"
+
+#include <esp_timer.h>
+
+#include "spscRing.h"
+
+inputCaptureStatistics inputCaptureStats;
+
+static spscRing<inputEdge, INPUT_EDGE_QUEUE_SIZE> edgeQueue;
+static volatile uint32_t droppedEdges = 0;  // Written by the ISR only
+static uint32_t reportedDrops = 0;
+static uint8_t pendingEdges[MAX_IO_VARIABLES];  // Scan task only
+
+static void IRAM_ATTR inputEdgeISR(void *arg) {
+  inputEdge edge;
+  edge.timestampUs = (uint32_t)esp_timer_get_time();
+  edge.slot = (uint8_t)(uintptr_t)arg;
+  if (!edgeQueue.push(edge)) droppedEdges = droppedEdges + 1;
+}
+
+bool isEdgeMode(operationMode mode) {
+  return mode == rising || mode == falling || mode == stateChange;
+}
+
+void startInputCapture() {
+  inputCaptureStats.edges = 0;
+  inputCaptureStats.overruns = 0;
+  inputCaptureStats.maxEdgeLatencyUs = 0;
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    const IOVariable &io = IOVariables[i];
+    pendingEdges[i] = 0;
+    if (!io.status || io.type != DigitalInput || !isEdgeMode(io.mode)) {
+      continue;
+    }
+    int trigger = (io.mode == rising)    ? RISING
+                  : (io.mode == falling) ? FALLING
+                                         : CHANGE;
+    attachInterruptArg(digitalPinToInterrupt(io.gpio), inputEdgeISR,
+                       (void *)(uintptr_t)i, trigger);
+  }
+}
+
+void stopInputCapture() {
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    const IOVariable &io = IOVariables[i];
+    if (io.status && io.type == DigitalInput && isEdgeMode(io.mode)) {
+      detachInterrupt(digitalPinToInterrupt(io.gpio));
+    }
+  }
+  inputEdge edge;
+  while (edgeQueue.pop(edge)) {
+  }
+}
+
+void drainInputEdges(uint32_t nowUs) {
+  inputEdge edge;
+  while (edgeQueue.pop(edge)) {
+    if (pendingEdges[edge.slot] < UINT8_MAX) {
+      pendingEdges[edge.slot]++;
+    } else {
+      inputCaptureStats.overruns++;
+    }
+    uint32_t latencyUs = nowUs - edge.timestampUs;
+    if (latencyUs > inputCaptureStats.maxEdgeLatencyUs) {
+      inputCaptureStats.maxEdgeLatencyUs = latencyUs;
+    }
+    inputCaptureStats.edges++;
+  }
+  uint32_t drops = droppedEdges;  // Monotonic, never reset by the consumer
+  inputCaptureStats.overruns += drops - reportedDrops;
+  reportedDrops = drops;
+}
+
+bool takeInputEdge(uint8_t slot, bool flagWasSet) {
+  if (flagWasSet || pendingEdges[slot] == 0) return false;
+  pendingEdges[slot]--;
+  return true;
+}
@@ -0,0 +1,44 @@
+#ifndef INPUT_CAPTURE_H
+#define INPUT_CAPTURE_H
+
+#include <Arduino.h>
+
+#include "dataStructure.h"
+
+// GPIO interrupt capture for DigitalInputs in rising, falling and stateChange
+// mode. ISRs push timestamped edges into a lock-free ring that the scan task
+// drains during its input latch, so pulses shorter than a scan are not lost.
+
+#define INPUT_EDGE_QUEUE_SIZE 64  // Power of two
+
+struct inputEdge {
+  uint32_t timestampUs;  // esp_timer time of the interrupt
+  uint8_t slot;          // IOVariables[] index of the DigitalInput
+};
+
+struct inputCaptureStatistics {
+  uint32_t edges;             // Edges consumed by the scan task
+  uint32_t overruns;          // Edges dropped because the ring was full
+  uint32_t maxEdgeLatencyUs;  // Interrupt to latch, worst case
+};
+
+extern inputCaptureStatistics inputCaptureStats;
+
+bool isEdgeMode(operationMode mode);
+
+// Attach interrupts for enabled edge-mode DigitalInputs. Call from the scan
+// task so the ISRs run on the same core as the consumer.
+void startInputCapture();
+
+// Detach the interrupts attached for the current IOVariables image and
+// discard queued edges (scan task only, before switching images)
+void stopInputCapture();
+
+// Move queued edges into per-input pending counts (scan task only)
+void drainInputEdges(uint32_t nowUs);
+
+// Flag value for this scan: true for exactly one scan per captured edge,
+// with a false scan in between so every edge is seen as a new event.
+bool takeInputEdge(uint8_t slot, bool flagWasSet);
+
+#endif  // INPUT_CAPTURE_H
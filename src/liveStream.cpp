@@ -0,0 +1,103 @@
+#include "liveStream.h"
+
+#include <atomic>
+
+#include "processImage.h"
+
+struct liveClient {
+  uint32_t id;  // 0 = free
+  uint32_t lastSentMs;
+  bool needsFull;
+  processEntry seen[MAX_IO_VARIABLES];  // What this client has been sent
+};
+
+static AsyncWebSocket liveSocket(LIVE_STREAM_PATH);
+static liveClient clients[LIVE_MAX_CLIENTS];
+static portMUX_TYPE clientLock = portMUX_INITIALIZER_UNLOCKED;
+static std::atomic<uint8_t> clientCount(0);
+
+static bool sameEntry(const processEntry &a, const processEntry &b) {
+  return a.state == b.state && a.flag == b.flag && a.value == b.value;
+}
+
+static void onLiveEvent(AsyncWebSocket *socket, AsyncWebSocketClient *client,
+                        AwsEventType type, void *arg, uint8_t *data,
+                        size_t len) {
+  if (type == WS_EVT_CONNECT) {
+    bool added = false;
+    portENTER_CRITICAL(&clientLock);
+    for (uint8_t c = 0; c < LIVE_MAX_CLIENTS && !added; c++) {
+      if (clients[c].id != 0) continue;
+      clients[c].id = client->id();
+      clients[c].lastSentMs = 0;
+      clients[c].needsFull = true;
+      added = true;
+    }
+    portEXIT_CRITICAL(&clientLock);
+    if (added) {
+      clientCount.fetch_add(1);
+    } else {
+      client->close();  // Every watcher costs a frame per interval
+    }
+  } else if (type == WS_EVT_DISCONNECT) {
+    bool removed = false;
+    portENTER_CRITICAL(&clientLock);
+    for (uint8_t c = 0; c < LIVE_MAX_CLIENTS; c++) {
+      if (clients[c].id == client->id()) {
+        clients[c].id = 0;
+        removed = true;
+      }
+    }
+    portEXIT_CRITICAL(&clientLock);
+    if (removed) clientCount.fetch_sub(1);
+  }
+}
+
+void setupLiveStream(AsyncWebServer &server) {
+  liveSocket.onEvent(onLiveEvent);
+  server.addHandler(&liveSocket);
+}
+
+void serviceLiveStream() {
+  liveSocket.cleanupClients();
+  if (clientCount.load(std::memory_order_relaxed) == 0) return;
+
+  processImage snapshot;
+  if (!readProcessImage(snapshot)) return;  // No scan yet
+  const processEntry *image = snapshot.io;
+
+  uint8_t frame[LIVE_FRAME_HEADER + LIVE_ENTRY_SIZE * MAX_IO_VARIABLES];
+  uint32_t nowMs = millis();
+  for (uint8_t c = 0; c < LIVE_MAX_CLIENTS; c++) {
+    portENTER_CRITICAL(&clientLock);
+    uint32_t id = clients[c].id;
+    bool due = id != 0 && nowMs - clients[c].lastSentMs >= LIVE_MIN_INTERVAL_MS;
+    bool full = clients[c].needsFull;
+    portEXIT_CRITICAL(&clientLock);
+    if (!due || !liveSocket.availableForWrite(id)) continue;
+
+    // Only this task touches 'seen'; the event handler only claims and
+    // frees the slot, which is re-checked before committing below
+    size_t len = LIVE_FRAME_HEADER;
+    frame[0] = full ? LIVE_FRAME_FULL : LIVE_FRAME_DELTA;
+    memcpy(frame + 1, &snapshot.cycle, sizeof(snapshot.cycle));
+    for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+      if (!IOVariables[i].status) continue;
+      if (!full && sameEntry(image[i], clients[c].seen[i])) continue;
+      frame[len] = i;
+      frame[len + 1] = (image[i].state ? 1 : 0) | (image[i].flag ? 2 : 0);
+      memcpy(frame + len + 2, &image[i].value, sizeof(int32_t));
+      len += LIVE_ENTRY_SIZE;
+    }
+    if (len == LIVE_FRAME_HEADER) continue;  // Nothing changed for it
+
+    liveSocket.binary(id, frame, len);
+    portENTER_CRITICAL(&clientLock);
+    if (clients[c].id == id) {
+      memcpy(clients[c].seen, image, sizeof(snapshot.io));
+      clients[c].lastSentMs = nowMs;
+      clients[c].needsFull = false;
+    }
+    portEXIT_CRITICAL(&clientLock);
+  }
+}
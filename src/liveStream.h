@@ -0,0 +1,32 @@
+#ifndef LIVE_STREAM_H
+#define LIVE_STREAM_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#include "dataStructure.h"
+
+// Live runtime state of the IOVariables over a WebSocket. The network task
+// takes a snapshot of the process image (processImage.h) and sends each
+// client the slots that changed since its last frame, at most every
+// LIVE_MIN_INTERVAL_MS.
+//
+// Binary frames, little-endian:
+//   uint8  kind      LIVE_FRAME_FULL or LIVE_FRAME_DELTA
+//   uint32 cycle     scanStats.cycles when the image was published
+//   then per slot:   uint8 slot, uint8 bits (0: state, 1: flag), int32 value
+
+#define LIVE_STREAM_PATH "/live"
+#define LIVE_MAX_CLIENTS 4
+#define LIVE_MIN_INTERVAL_MS 100  // Per client
+#define LIVE_SERVICE_MS 20        // Network task polling period
+
+#define LIVE_FRAME_FULL 0
+#define LIVE_FRAME_DELTA 1
+#define LIVE_FRAME_HEADER 5
+#define LIVE_ENTRY_SIZE 6
+
+void setupLiveStream(AsyncWebServer &server);
+void serviceLiveStream();  // Network task, every LIVE_SERVICE_MS
+
+#endif  // LIVE_STREAM_H
@@ -1,15 +1,18 @@
 #include <Arduino.h>
-// #include <ESP32TimerInterrupt.h>  // Hardware Timer
 #include <Preferences.h>   // NVS for WiFi credentials (can be shared)
 #include <RTClib.h>        // timekeeping for scheduling
-#include <TickTwo.h>       // Software Timer
 #include <WiFi.h>          // Needed for WiFi status checks
-#include <WiFiUdp.h>       // Needed for ntpClient
 #include <esp_task_wdt.h>  // Watchdog timer
-#include <ntpclient.h>     // Network Time
 
 #include "configPortal.h"   // Include config portal header
+#include "configStore.h"    // Background config saves
 #include "dataStructure.h"  // Include data structures
+#include "eventRecorder.h"  // IOVariable change and rule firing log
+#include "liveStream.h"     // Live IOVariable state for the web UI
+#include "modbusServer.h"   // Modbus TCP access to the process image
+#include "persistence.h"    // Retained SoftIO/Timer values in NVS
+#include "scanEngine.h"     // PLC scan cycle on core 1
+#include "timeSync.h"       // Wall clock for Schedule IOVariables
 
 TaskHandle_t networkTask;
 void networkTaskFunction(void *pvParameters);
@@ -35,11 +38,19 @@ void networkTaskFunction(void *pvParameters) {
   esp_task_wdt_add(NULL);
 
   initiateConfig();
+  startConfigStore();  // Saves uploads off the web server task
+  startPersistence();  // Retained values before the first scan sees them
+  startEventRecorder();
+  startTimeSync();    // Schedules need the RTC time before the first scan
+  startScanEngine();  // Control runs before and without WiFi
   initiateWiFi();
   setupWebServer();
+  setupModbusServer();
 
   for (;;) {
-    delay(1000);
+    delay(LIVE_SERVICE_MS);
+    serviceLiveStream();
+    serviceTimeSync();
     esp_task_wdt_reset();
   }
 }
@@ -0,0 +1,260 @@
+#include "metrics.h"
+
+#include <WiFi.h>
+
+#include "analogInput.h"
+#include "configJson.h"
+#include "configStore.h"
+#include "configValidator.h"
+#include "eventRecorder.h"
+#include "inputCapture.h"
+#include "modbusProtocol.h"
+#include "persistence.h"
+#include "processImage.h"
+#include "ruleEngine.h"
+#include "scanEngine.h"
+#include "scheduler.h"
+#include "timeSync.h"
+#include "timerService.h"
+
+static const uint32_t scanBoundsUs[METRICS_BUCKETS] = {
+    25, 50, 100, 250, 500, 1000, 2500, 5000, 10000};
+static const uint32_t webBoundsUs[METRICS_BUCKETS] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 50000, 250000};
+
+// Written by the scan task only
+static metricHistogram scanExecHistogram = {scanBoundsUs};
+static metricHistogram scanJitterHistogram = {scanBoundsUs};
+// Written by the async_tcp task only
+static metricHistogram webHistogram = {webBoundsUs};
+
+// Tasks whose stack high-water mark is reported
+static const char *const stackTasks[] = {
+    "loopTask", "networkTask", "scanTask", "analogTask",
+    "persistTask", "eventTask", "storeTask", "async_tcp", "esp_timer"};
+
+static void observe(metricHistogram &histogram, uint32_t value) {
+  uint8_t b = 0;
+  while (b < METRICS_BUCKETS && value > histogram.bounds[b]) b++;
+  histogram.counts[b]++;
+  histogram.sum += value;
+}
+
+void observeScan(int32_t jitterUs, uint32_t execUs) {
+  observe(scanExecHistogram, execUs);
+  observe(scanJitterHistogram, (uint32_t)abs(jitterUs));
+}
+
+// --- Prometheus Text Output ---
+static void printHeader(Print &out, const char *name, const char *type,
+                        const char *help) {
+  out.printf("# HELP " METRICS_PREFIX "%s %s\n# TYPE " METRICS_PREFIX
+             "%s %s\n",
+             name, help, name, type);
+}
+
+static void printValue(Print &out, const char *name, const char *type,
+                       const char *help, uint32_t value) {
+  printHeader(out, name, type, help);
+  out.printf(METRICS_PREFIX "%s %u\n", name, (unsigned)value);
+}
+
+static void printHistogram(Print &out, const char *name, const char *help,
+                           const metricHistogram &histogram) {
+  // Snapshot first so the buckets, sum and count agree with each other
+  uint32_t counts[METRICS_BUCKETS + 1];
+  memcpy(counts, histogram.counts, sizeof(counts));
+  uint32_t sum = histogram.sum;
+
+  printHeader(out, name, "histogram", help);
+  uint32_t cumulative = 0;
+  for (uint8_t b = 0; b < METRICS_BUCKETS; b++) {
+    cumulative += counts[b];
+    out.printf(METRICS_PREFIX "%s_bucket{le=\"%u\"} %u\n", name,
+               (unsigned)histogram.bounds[b], (unsigned)cumulative);
+  }
+  cumulative += counts[METRICS_BUCKETS];
+  out.printf(METRICS_PREFIX "%s_bucket{le=\"+Inf\"} %u\n", name,
+             (unsigned)cumulative);
+  out.printf(METRICS_PREFIX "%s_sum %u\n", name, (unsigned)sum);
+  out.printf(METRICS_PREFIX "%s_count %u\n", name, (unsigned)cumulative);
+}
+
+static void printRuleProfile(Print &out) {
+  const ruleProgram &program = *activeProgram;
+  uint32_t cyclesPerUs = ESP.getCpuFreqMHz();
+  printHeader(out, "rule_evaluations_total", "counter",
+              "Evaluations of each rule since its program became active.");
+  for (logicId r = 0; r < program.ruleCount; r++) {
+    out.printf(METRICS_PREFIX "rule_evaluations_total{rule=\"%u\"} %u\n",
+               program.ruleNum[r], (unsigned)ruleProfile.evals[r]);
+  }
+  printHeader(out, "rule_eval_us_total", "counter",
+              "Time spent evaluating each rule, in microseconds.");
+  for (logicId r = 0; r < program.ruleCount; r++) {
+    out.printf(METRICS_PREFIX "rule_eval_us_total{rule=\"%u\"} %u\n",
+               program.ruleNum[r],
+               (unsigned)(ruleProfile.cycles[r] / cyclesPerUs));
+  }
+}
+
+static void printTaskStacks(Print &out) {
+  printHeader(out, "task_stack_free_bytes", "gauge",
+              "Lowest free stack space of each task since it started.");
+  for (const char *name : stackTasks) {
+    TaskHandle_t task = xTaskGetHandle(name);
+    if (task == NULL) continue;
+    out.printf(METRICS_PREFIX "task_stack_free_bytes{task=\"%s\"} %u\n", name,
+               (unsigned)uxTaskGetStackHighWaterMark(task));
+  }
+}
+
+static void printMetrics(Print &out) {
+  printHistogram(out, "scan_exec_us",
+                 "Scan execution time (latch, rules, commit), microseconds.",
+                 scanExecHistogram);
+  printHistogram(out, "scan_jitter_us",
+                 "Scan wake-up time minus scheduled time, microseconds.",
+                 scanJitterHistogram);
+  printValue(out, "scan_cycles_total", "counter", "Completed scan cycles.",
+             scanStats.cycles);
+  printValue(out, "scan_overruns_total", "counter",
+             "Scan cycles that exceeded the scan period.",
+             scanStats.overruns);
+  printValue(out, "scan_period_ms", "gauge", "Configured scan period.",
+             defaultConfig.scanPeriodMs);
+  printValue(out, "config_swaps_total", "counter",
+             "Configuration images switched to.", scanStats.swaps);
+  printValue(out, "config_wcet_us", "gauge",
+             "Estimated worst-case scan time of the active configuration.",
+             validatorStats.worstCaseUs);
+  printValue(out, "config_budget_us", "gauge",
+             "Scan time a configuration may take before it is rejected.",
+             validatorStats.budgetUs);
+  printValue(out, "config_rejected_total", "counter",
+             "Configuration uploads refused by the validator.",
+             validatorStats.rejectedUploads);
+  printValue(out, "config_saves_pending", "gauge",
+             "Configuration generations applied but not yet on flash.",
+             configStoreStats.requested - configStoreStats.saved);
+  printValue(out, "config_save_failures_total", "counter",
+             "Configuration saves that left the files unchanged.",
+             configStoreStats.failures);
+  printValue(out, "config_save_rewrites_total", "counter",
+             "Configuration temp files rewritten after an overlapping change.",
+             configStoreStats.rewrites);
+  printValue(out, "config_save_max_ms", "gauge",
+             "Longest configuration save, milliseconds.",
+             configStoreStats.maxSaveMs);
+
+  printValue(out, "rule_engine_evaluations_total", "counter",
+             "Rules re-evaluated since the engine was reset.",
+             ruleEngineStats.totalRuleEvals);
+  printRuleProfile(out);
+
+  printValue(out, "timer_expirations_total", "counter",
+             "Timer and delayed output deadlines reached.",
+             timerServiceStats.expirations);
+  printValue(out, "timer_max_lateness_us", "gauge",
+             "Worst timer callback lateness, microseconds.",
+             timerServiceStats.maxLatenessUs);
+  printValue(out, "input_edges_total", "counter",
+             "Digital input edges captured.", inputCaptureStats.edges);
+  printValue(out, "input_edge_overruns_total", "counter",
+             "Digital input edges dropped (ring full).",
+             inputCaptureStats.overruns);
+  printValue(out, "analog_samples_total", "counter",
+             "ADC conversions received over DMA.", analogInputStats.samples);
+  printValue(out, "analog_overflows_total", "counter",
+             "ADC DMA frames lost.", analogInputStats.overflows);
+  printValue(out, "analog_start_failures_total", "counter",
+             "ADC DMA starts failed, inputs fell back to analogRead().",
+             analogInputStats.startFailures);
+  printValue(out, "persist_writes_total", "counter",
+             "Retained value blobs written to NVS.", persistStats.writes);
+  printValue(out, "persist_failures_total", "counter",
+             "Failed NVS writes of retained values.", persistStats.failures);
+  printValue(out, "persist_max_write_us", "gauge",
+             "Longest NVS write of retained values, microseconds.",
+             persistStats.maxWriteUs);
+  printValue(out, "schedule_transitions_total", "counter",
+             "Schedule window transitions reached.", schedulerStats.fired);
+  printValue(out, "schedule_rebuilds_total", "counter",
+             "Schedule deadline recomputations (swap, clock step).",
+             schedulerStats.rebuilds);
+  printValue(out, "clock_valid", "gauge",
+             "Wall clock held a plausible date at the last rebuild.",
+             schedulerStats.clockValid);
+  printValue(out, "time_syncs_total", "counter", "SNTP updates applied.",
+             timeSyncStats.syncs);
+
+  printValue(out, "process_image_read_retries_total", "counter",
+             "Process image snapshots copied again after an overwrite.",
+             processImageStats.readRetries);
+  printValue(out, "io_commands_applied_total", "counter",
+             "Web and Modbus writes applied at a scan boundary.",
+             processImageStats.commandsApplied);
+  printValue(out, "io_commands_dropped_total", "counter",
+             "Runtime writes refused because the command queue was full.",
+             processImageStats.commandsDropped);
+
+  printValue(out, "modbus_requests_total", "counter",
+             "Modbus TCP requests handled.", modbusStats.requests);
+  printValue(out, "modbus_exceptions_total", "counter",
+             "Modbus TCP requests answered with an exception.",
+             modbusStats.exceptions);
+  printValue(out, "modbus_writes_total", "counter",
+             "Values queued by Modbus TCP writes.", modbusStats.writes);
+  printValue(out, "modbus_clients", "gauge",
+             "Connected Modbus TCP clients.", modbusStats.clients);
+  printValue(out, "modbus_refused_total", "counter",
+             "Modbus TCP connections closed for lack of a client slot.",
+             modbusStats.refused);
+
+  printValue(out, "events_recorded_total", "counter",
+             "Events put in the event ring.", eventRingStats.recorded);
+  printValue(out, "events_dropped_total", "counter",
+             "Events lost because the event ring was full.",
+             eventRingStats.dropped);
+  printValue(out, "event_pages_written_total", "counter",
+             "Event pages appended to LittleFS.",
+             eventRecorderStats.pagesWritten);
+  printValue(out, "event_max_page_write_us", "gauge",
+             "Longest event page write, microseconds.",
+             eventRecorderStats.maxPageWriteUs);
+
+  printValue(out, "heap_free_bytes", "gauge", "Free heap.",
+             ESP.getFreeHeap());
+  printValue(out, "heap_min_free_bytes", "gauge",
+             "Lowest free heap since boot.", ESP.getMinFreeHeap());
+  printValue(out, "heap_largest_block_bytes", "gauge",
+             "Largest allocatable heap block.", ESP.getMaxAllocHeap());
+  printTaskStacks(out);
+
+  printHistogram(out, "web_handler_us",
+                 "Time web request handlers held the server, microseconds.",
+                 webHistogram);
+  if (WiFi.status() == WL_CONNECTED) {
+    printHeader(out, "wifi_rssi_dbm", "gauge", "Station signal strength.");
+    out.printf(METRICS_PREFIX "wifi_rssi_dbm %d\n", (int)WiFi.RSSI());
+  }
+}
+// --- End Prometheus Text Output ---
+
+void setupMetrics(AsyncWebServer &server) {
+  // Every handler runs on the async_tcp task; time spent there blocks all
+  // other clients, so that is what is measured
+  server.addMiddleware(
+      [](AsyncWebServerRequest *request, ArMiddlewareNext next) {
+        uint32_t startUs = micros();
+        next();
+        observe(webHistogram, micros() - startUs);
+      });
+
+  server.on(METRICS_PATH, HTTP_GET, [](AsyncWebServerRequest *request) {
+    AsyncResponseStream *response =
+        request->beginResponseStream("text/plain; version=0.0.4");
+    printMetrics(*response);
+    request->send(response);
+  });
+}
@@ -0,0 +1,27 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+// Runtime telemetry in the Prometheus text format at /metrics. The scan
+// task only bumps plain counters it alone writes (no locks, no atomics
+// beyond single aligned stores); everything else (heap, task stacks, WiFi,
+// the statistics of the other modules) is read when the page is scraped.
+// Histogram sums are 32-bit microsecond counters; a wrap looks like a
+// counter reset, which rate() handles.
+
+#define METRICS_PATH "/metrics"
+#define METRICS_PREFIX "advtimer_"
+#define METRICS_BUCKETS 9  // Finite bounds, plus the implicit +Inf
+
+struct metricHistogram {
+  const uint32_t *bounds;                 // METRICS_BUCKETS upper bounds
+  uint32_t counts[METRICS_BUCKETS + 1];   // Per bucket, last is +Inf
+  uint32_t sum;
+};
+
+void observeScan(int32_t jitterUs, uint32_t execUs);  // Scan task only
+void setupMetrics(AsyncWebServer &server);
+
+#endif  // METRICS_H
@@ -0,0 +1,286 @@
+#include "modbusProtocol.h"
+
+#include "processImage.h"
+
+modbusStatistics modbusStats;
+
+#define FC_READ_COILS 1
+#define FC_READ_DISCRETE_INPUTS 2
+#define FC_READ_HOLDING_REGISTERS 3
+#define FC_READ_INPUT_REGISTERS 4
+#define FC_WRITE_COIL 5
+#define FC_WRITE_REGISTER 6
+#define FC_WRITE_COILS 15
+#define FC_WRITE_REGISTERS 16
+
+#define EX_ILLEGAL_FUNCTION 1
+#define EX_ILLEGAL_ADDRESS 2
+#define EX_ILLEGAL_VALUE 3
+#define EX_DEVICE_BUSY 6  // No image yet, or the command queue is full
+
+// Protocol limits that keep a response within one ADU
+#define MAX_READ_BITS 2000
+#define MAX_READ_REGISTERS 125
+#define MAX_WRITE_BITS 1968
+#define MAX_WRITE_REGISTERS 123
+
+static processImage snapshot;  // Too big for the async_tcp stack
+
+static uint16_t getWord(const uint8_t *bytes) {
+  return (uint16_t)(bytes[0] << 8 | bytes[1]);
+}
+
+static void putWord(uint8_t *bytes, uint16_t word) {
+  bytes[0] = word >> 8;
+  bytes[1] = word & 0xFF;
+}
+
+// --- Address Map ---
+// IOVariables[] slot of a coil or discrete input, -1 if unmapped
+static int bitSlot(bool coils, uint16_t address) {
+  if (!coils) return address < MAX_DIGITAL_IN ? FIRST_DIGITAL_IN + address : -1;
+  if (address < MAX_DIGITAL_OUT) return FIRST_DIGITAL_OUT + address;
+  if (address >= MODBUS_SOFTIO_COILS &&
+      address - MODBUS_SOFTIO_COILS < MAX_SOFTIO) {
+    return FIRST_SOFTIO + address - MODBUS_SOFTIO_COILS;
+  }
+  return -1;
+}
+
+// Slot of a holding or input register, -1 if unmapped; 'high' tells which
+// half of the 32-bit value the register holds
+static int registerSlot(bool holding, uint16_t address, bool &high) {
+  uint16_t offset = address;
+  uint8_t first = FIRST_ANALOG_IN;
+  uint8_t count = MAX_ANALOG_IN;
+  if (holding && address < MODBUS_TIMER_REGISTERS) {
+    first = FIRST_SOFTIO;
+    count = MAX_SOFTIO;
+  } else if (holding) {
+    offset -= MODBUS_TIMER_REGISTERS;
+    first = FIRST_TIMER;
+    count = MAX_TIMERS;
+  }
+  if (offset / 2 >= count) return -1;
+  high = (offset & 1) == 0;
+  return first + offset / 2;
+}
+
+static bool inRange(uint16_t address, uint16_t quantity) {
+  return (uint32_t)address + quantity <= 0x10000;
+}
+// --- End Address Map ---
+
+// --- Reads ---
+// Each handler returns 0 and fills 'out' with the response PDU, or returns
+// the exception code
+static uint8_t readBits(const uint8_t *pdu, size_t length, uint8_t *out,
+                        size_t &outLength) {
+  if (length != 5) return EX_ILLEGAL_VALUE;
+  bool coils = pdu[0] == FC_READ_COILS;
+  uint16_t address = getWord(pdu + 1);
+  uint16_t quantity = getWord(pdu + 3);
+  if (quantity == 0 || quantity > MAX_READ_BITS) return EX_ILLEGAL_VALUE;
+  if (!inRange(address, quantity)) return EX_ILLEGAL_ADDRESS;
+  for (uint16_t i = 0; i < quantity; i++) {
+    if (bitSlot(coils, address + i) < 0) return EX_ILLEGAL_ADDRESS;
+  }
+  if (!readProcessImage(snapshot)) return EX_DEVICE_BUSY;
+
+  out[0] = pdu[0];
+  out[1] = (quantity + 7) / 8;
+  memset(out + 2, 0, out[1]);
+  for (uint16_t i = 0; i < quantity; i++) {
+    int slot = bitSlot(coils, address + i);
+    if (IOVariables[slot].status && snapshot.io[slot].state) {
+      out[2 + i / 8] |= 1 << (i % 8);
+    }
+  }
+  outLength = 2 + out[1];
+  return 0;
+}
+
+static uint8_t readRegisters(const uint8_t *pdu, size_t length, uint8_t *out,
+                             size_t &outLength) {
+  if (length != 5) return EX_ILLEGAL_VALUE;
+  bool holding = pdu[0] == FC_READ_HOLDING_REGISTERS;
+  uint16_t address = getWord(pdu + 1);
+  uint16_t quantity = getWord(pdu + 3);
+  if (quantity == 0 || quantity > MAX_READ_REGISTERS) return EX_ILLEGAL_VALUE;
+  if (!inRange(address, quantity)) return EX_ILLEGAL_ADDRESS;
+  bool high;
+  for (uint16_t i = 0; i < quantity; i++) {
+    if (registerSlot(holding, address + i, high) < 0) return EX_ILLEGAL_ADDRESS;
+  }
+  if (!readProcessImage(snapshot)) return EX_DEVICE_BUSY;
+
+  out[0] = pdu[0];
+  out[1] = quantity * 2;
+  for (uint16_t i = 0; i < quantity; i++) {
+    int slot = registerSlot(holding, address + i, high);
+    uint32_t value = IOVariables[slot].status ? snapshot.io[slot].value : 0;
+    putWord(out + 2 + 2 * i, high ? value >> 16 : value & 0xFFFF);
+  }
+  outLength = 2 + out[1];
+  return 0;
+}
+// --- End Reads ---
+
+// --- Writes ---
+// A request is checked completely before its first command is queued, so
+// it is either applied as a whole or refused. 'queue' false only checks
+// and counts the commands.
+static uint8_t writeCoilValues(uint16_t address, uint16_t quantity,
+                               const uint8_t *bits, bool queue,
+                               uint16_t &commands) {
+  commands = 0;
+  for (uint16_t i = 0; i < quantity; i++) {
+    int slot = bitSlot(true, address + i);
+    if (slot < 0 || !isWritableField(IOVariables[slot], IO_FIELD_STATE)) {
+      return EX_ILLEGAL_ADDRESS;
+    }
+    commands++;
+    if (queue) {
+      bool on = bits[i / 8] & (1 << (i % 8));
+      queueIOCommand({(uint8_t)slot, IO_FIELD_STATE, on});
+    }
+  }
+  return 0;
+}
+
+static uint8_t writeRegisterValues(uint16_t address, uint16_t quantity,
+                                   const uint8_t *words, bool queue,
+                                   uint16_t &commands) {
+  commands = 0;
+  uint16_t i = 0;
+  while (i < quantity) {
+    bool high;
+    int slot = registerSlot(true, address + i, high);
+    if (slot < 0 || !isWritableField(IOVariables[slot], IO_FIELD_VALUE)) {
+      return EX_ILLEGAL_ADDRESS;
+    }
+    int32_t value;
+    if (high) {
+      if (i + 1 >= quantity) return EX_ILLEGAL_ADDRESS;  // Half a value
+      value = (int32_t)((uint32_t)getWord(words + 2 * i) << 16 |
+                        getWord(words + 2 * i + 2));
+      i += 2;
+    } else {
+      value = (int16_t)getWord(words + 2 * i);
+      i++;
+    }
+    commands++;
+    if (queue) queueIOCommand({(uint8_t)slot, IO_FIELD_VALUE, value});
+  }
+  return 0;
+}
+
+static uint8_t writeValues(bool coils, uint16_t address, uint16_t quantity,
+                           const uint8_t *data) {
+  uint16_t commands;
+  uint8_t exception =
+      coils ? writeCoilValues(address, quantity, data, false, commands)
+            : writeRegisterValues(address, quantity, data, false, commands);
+  if (exception) return exception;
+  if (ioCommandSpace() < commands) return EX_DEVICE_BUSY;
+  if (coils) {
+    writeCoilValues(address, quantity, data, true, commands);
+  } else {
+    writeRegisterValues(address, quantity, data, true, commands);
+  }
+  modbusStats.writes += commands;
+  return 0;
+}
+
+static uint8_t writeSingle(const uint8_t *pdu, size_t length, uint8_t *out,
+                           size_t &outLength) {
+  if (length != 5) return EX_ILLEGAL_VALUE;
+  bool coil = pdu[0] == FC_WRITE_COIL;
+  uint16_t address = getWord(pdu + 1);
+  uint8_t exception;
+  if (coil) {
+    uint16_t value = getWord(pdu + 3);
+    if (value != 0xFF00 && value != 0x0000) return EX_ILLEGAL_VALUE;
+    uint8_t bits = value ? 1 : 0;
+    exception = writeValues(true, address, 1, &bits);
+  } else {
+    exception = writeValues(false, address, 1, pdu + 3);
+  }
+  if (exception) return exception;
+  memcpy(out, pdu, 5);  // Echo of the request
+  outLength = 5;
+  return 0;
+}
+
+static uint8_t writeMultiple(const uint8_t *pdu, size_t length, uint8_t *out,
+                             size_t &outLength) {
+  if (length < 6) return EX_ILLEGAL_VALUE;
+  bool coils = pdu[0] == FC_WRITE_COILS;
+  uint16_t address = getWord(pdu + 1);
+  uint16_t quantity = getWord(pdu + 3);
+  uint16_t limit = coils ? MAX_WRITE_BITS : MAX_WRITE_REGISTERS;
+  size_t bytes = coils ? (quantity + 7) / 8 : quantity * 2;
+  if (quantity == 0 || quantity > limit || pdu[5] != bytes ||
+      length != 6 + bytes) {
+    return EX_ILLEGAL_VALUE;
+  }
+  if (!inRange(address, quantity)) return EX_ILLEGAL_ADDRESS;
+  uint8_t exception = writeValues(coils, address, quantity, pdu + 6);
+  if (exception) return exception;
+  memcpy(out, pdu, 5);  // Function, address and quantity
+  outLength = 5;
+  return 0;
+}
+// --- End Writes ---
+
+int modbusFrameLength(const uint8_t *frame, size_t received) {
+  if (received < MODBUS_MBAP_SIZE) return 0;
+  uint16_t length = getWord(frame + 4);  // Unit ID and PDU
+  if (getWord(frame + 2) != 0 || length < 2 || length + 6 > MODBUS_MAX_ADU) {
+    return -1;
+  }
+  return length + 6;
+}
+
+size_t handleModbusFrame(const uint8_t *request, size_t length,
+                         uint8_t *response) {
+  if (length <= MODBUS_MBAP_SIZE) return 0;
+  modbusStats.requests++;
+  const uint8_t *pdu = request + MODBUS_MBAP_SIZE;
+  size_t pduLength = length - MODBUS_MBAP_SIZE;
+  uint8_t *out = response + MODBUS_MBAP_SIZE;
+  size_t outLength = 0;
+
+  uint8_t exception;
+  switch (pdu[0]) {
+    case FC_READ_COILS:
+    case FC_READ_DISCRETE_INPUTS:
+      exception = readBits(pdu, pduLength, out, outLength);
+      break;
+    case FC_READ_HOLDING_REGISTERS:
+    case FC_READ_INPUT_REGISTERS:
+      exception = readRegisters(pdu, pduLength, out, outLength);
+      break;
+    case FC_WRITE_COIL:
+    case FC_WRITE_REGISTER:
+      exception = writeSingle(pdu, pduLength, out, outLength);
+      break;
+    case FC_WRITE_COILS:
+    case FC_WRITE_REGISTERS:
+      exception = writeMultiple(pdu, pduLength, out, outLength);
+      break;
+    default:
+      exception = EX_ILLEGAL_FUNCTION;
+  }
+  if (exception) {
+    out[0] = pdu[0] | 0x80;
+    out[1] = exception;
+    outLength = 2;
+    modbusStats.exceptions++;
+  }
+
+  memcpy(response, request, 4);  // Transaction and protocol ID
+  putWord(response + 4, outLength + 1);
+  response[6] = request[6];  // Unit ID, answered whatever it is
+  return MODBUS_MBAP_SIZE + outLength;
+}
@@ -0,0 +1,60 @@
+#ifndef MODBUS_PROTOCOL_H
+#define MODBUS_PROTOCOL_H
+
+#include <Arduino.h>
+
+#include "dataStructure.h"
+
+// Modbus TCP request handling over the process image, without any network
+// code so the host build serves the same frames (sim/modbusSim.cpp). Reads
+// come from one process image snapshot per request; writes are queued as
+// IO commands and take effect at the next scan boundary.
+//
+// Address map (0-based protocol addresses, entity n = 1..):
+//   Discrete inputs    n - 1                  DigitalInput n state
+//   Coils              n - 1                  DigitalOutput n state
+//                      MODBUS_SOFTIO_COILS + n - 1      SoftIO n state
+//   Input registers    2(n - 1)               AnalogInput n value
+//   Holding registers  2(n - 1)               SoftIO n value
+//                      MODBUS_TIMER_REGISTERS + 2(n - 1)  Timer n preset
+//
+// Values are 32-bit: two registers, high word first. A single register
+// write (function 6) to the low word stores the sign-extended 16-bit value;
+// the high word can only be written together with its low word. Disabled
+// entities read as 0 and refuse writes. Unmapped addresses in a request
+// answer exception 2, and so does a write to a read-only entity.
+//
+// Not reentrant: one task handles all connections.
+
+#define MODBUS_PORT 502
+#define MODBUS_MBAP_SIZE 7   // Header up to and including the unit ID
+#define MODBUS_MAX_ADU 260   // MBAP header + 253-byte PDU
+#define MODBUS_SOFTIO_COILS 100
+#define MODBUS_TIMER_REGISTERS 200
+
+static_assert(MAX_DIGITAL_OUT <= MODBUS_SOFTIO_COILS,
+              "Output coils overlap the SoftIO coils");
+static_assert(2 * MAX_SOFTIO <= MODBUS_TIMER_REGISTERS,
+              "SoftIO registers overlap the Timer registers");
+
+struct modbusStatistics {
+  uint32_t requests;     // Complete frames handled
+  uint32_t exceptions;   // Answered with an exception code
+  uint32_t writes;       // Values queued as IO commands
+  uint32_t connections;  // Accepted since boot
+  uint32_t refused;      // Closed because every client slot was taken
+  uint8_t clients;       // Currently connected
+};
+
+extern modbusStatistics modbusStats;
+
+// Length of the frame at the start of 'frame' once its header is in: 0
+// while fewer than MODBUS_MBAP_SIZE bytes have arrived, -1 for a header no
+// request can have (the connection should be closed).
+int modbusFrameLength(const uint8_t *frame, size_t received);
+// Handles one complete frame; returns the response length, 0 for none.
+// 'response' must hold MODBUS_MAX_ADU bytes.
+size_t handleModbusFrame(const uint8_t *request, size_t length,
+                         uint8_t *response);
+
+#endif  // MODBUS_PROTOCOL_H
@@ -0,0 +1,87 @@
+#include "modbusServer.h"
+
+#include <AsyncTCP.h>
+
+struct modbusConnection {
+  AsyncClient *client;  // nullptr = free
+  uint16_t received;    // Bytes in frame[]
+  uint8_t frame[MODBUS_MAX_ADU];
+};
+
+// Only touched from async_tcp callbacks
+static AsyncServer server(MODBUS_PORT);
+static modbusConnection connections[MODBUS_MAX_CLIENTS];
+static uint8_t response[MODBUS_MAX_ADU];
+
+// Answers every complete frame in the buffer and keeps the partial rest;
+// false if the stream is not Modbus TCP
+static bool answerFrames(modbusConnection &connection) {
+  uint16_t offset = 0;
+  for (;;) {
+    int length = modbusFrameLength(connection.frame + offset,
+                                   connection.received - offset);
+    if (length < 0) return false;
+    if (length == 0 || length > connection.received - offset) break;
+    size_t answer =
+        handleModbusFrame(connection.frame + offset, length, response);
+    if (answer > 0) connection.client->write((const char *)response, answer);
+    offset += length;
+  }
+  connection.received -= offset;
+  memmove(connection.frame, connection.frame + offset, connection.received);
+  return true;
+}
+
+static void onData(void *arg, AsyncClient *client, void *data, size_t len) {
+  modbusConnection &connection = *(modbusConnection *)arg;
+  const uint8_t *bytes = (const uint8_t *)data;
+  while (len > 0) {  // A frame never exceeds the buffer, so this progresses
+    size_t chunk = sizeof(connection.frame) - connection.received;
+    if (chunk > len) chunk = len;
+    memcpy(connection.frame + connection.received, bytes, chunk);
+    connection.received += chunk;
+    bytes += chunk;
+    len -= chunk;
+    if (!answerFrames(connection)) {
+      client->close();
+      return;
+    }
+  }
+}
+
+static void onDisconnect(void *arg, AsyncClient *client) {
+  modbusConnection *connection = (modbusConnection *)arg;
+  if (connection != nullptr) {
+    connection->client = nullptr;
+    modbusStats.clients--;
+  }
+  delete client;  // Accepted clients are owned by the callback
+}
+
+static void onConnect(void *arg, AsyncClient *client) {
+  modbusConnection *connection = nullptr;
+  for (uint8_t c = 0; c < MODBUS_MAX_CLIENTS && !connection; c++) {
+    if (connections[c].client == nullptr) connection = &connections[c];
+  }
+  client->onDisconnect(onDisconnect, connection);
+  if (connection == nullptr) {
+    modbusStats.refused++;
+    client->close(true);
+    return;
+  }
+  connection->client = client;
+  connection->received = 0;
+  modbusStats.connections++;
+  modbusStats.clients++;
+  client->setNoDelay(true);  // One small answer per request
+  client->setRxTimeout(MODBUS_IDLE_TIMEOUT_S);
+  client->onTimeout([](void *, AsyncClient *c, uint32_t) { c->close(); });
+  client->onData(onData, connection);
+}
+
+void setupModbusServer() {
+  server.onClient(onConnect, nullptr);
+  server.setNoDelay(true);
+  server.begin();
+  Serial.printf("Modbus TCP server on port %d\n", MODBUS_PORT);
+}
@@ -0,0 +1,18 @@
+#ifndef MODBUS_SERVER_H
+#define MODBUS_SERVER_H
+
+#include <Arduino.h>
+
+#include "modbusProtocol.h"
+
+// Modbus TCP slave on MODBUS_PORT for SCADA/HMI polling (register map in
+// modbusProtocol.h). Each connection reassembles frames in a fixed buffer
+// and is answered on the async_tcp task, so no request allocates memory
+// and pipelined requests are served in order.
+
+#define MODBUS_MAX_CLIENTS 4
+#define MODBUS_IDLE_TIMEOUT_S 60  // Clients silent this long are closed
+
+void setupModbusServer();  // Network task, once WiFi is up
+
+#endif  // MODBUS_SERVER_H
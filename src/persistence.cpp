@@ -0,0 +1,152 @@
+#include "persistence.h"
+
+#include <Preferences.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+
+#include <atomic>
+
+#include "configJson.h"
+#include "processImage.h"
+
+// One blob entry, keyed by type and number so it survives slot reordering
+struct retainedRecord {
+  uint8_t type;
+  uint8_t num;
+  uint8_t state;
+  uint8_t flag;
+  int32_t value;
+};
+
+persistStatistics persistStats;
+
+static retainedRecord written[MAX_RETAINED];  // Contents of the NVS blob
+static uint8_t writtenCount = 0;
+static std::atomic<bool> flushing(false);
+static TaskHandle_t persistTask = NULL;
+
+bool isRetained(const IOVariable &io) {
+  if (!io.status) return false;
+  return (io.type == SoftIO && io.mode == persistent) || io.type == Timer;
+}
+
+// Retained fields from a process image snapshot, or from the live image
+// before the scan task has started
+static uint8_t captureRetained(retainedRecord *records) {
+  static processImage snapshot;  // Only one capture runs at a time
+  bool hasSnapshot = readProcessImage(snapshot);
+  const IOVariable *image = IOVariables;
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES && count < MAX_RETAINED; i++) {
+    const IOVariable &io = image[i];
+    if (!isRetained(io)) continue;
+    retainedRecord &record = records[count++];
+    record.type = io.type;
+    record.num = io.num;
+    record.state = hasSnapshot ? snapshot.io[i].state : io.state;
+    record.flag = hasSnapshot ? snapshot.io[i].flag : io.flag;
+    record.value = hasSnapshot ? snapshot.io[i].value : io.value;
+  }
+  return count;
+}
+
+static uint8_t restoreRetainedValues() {
+  Preferences prefs;
+  if (!prefs.begin(PERSIST_NAMESPACE, true)) return 0;
+  retainedRecord records[MAX_RETAINED];
+  size_t length = prefs.getBytesLength(PERSIST_KEY);
+  uint8_t count = 0;
+  if (length > 0 && length <= sizeof(records) &&
+      length % sizeof(retainedRecord) == 0 &&
+      prefs.getBytes(PERSIST_KEY, records, length) == length) {
+    count = length / sizeof(retainedRecord);
+  }
+  prefs.end();
+
+  uint8_t restored = 0;
+  for (uint8_t r = 0; r < count; r++) {
+    int16_t slot = findIOVariableSlot((dataTypes)records[r].type,
+                                      records[r].num);
+    if (slot < 0 || !isRetained(IOVariables[slot])) continue;
+    IOVariable &io = IOVariables[slot];
+    io.value = records[r].value;
+    if (io.type == SoftIO) {  // A Timer restarts idle with its preset
+      io.state = records[r].state;
+      io.flag = records[r].flag;
+    }
+    restored++;
+  }
+  return restored;
+}
+
+bool flushRetainedValues() {
+  bool expected = false;
+  // Only one writer; a second caller waits for it and then compares again
+  while (!flushing.compare_exchange_weak(expected, true,
+                                         std::memory_order_acquire)) {
+    expected = false;
+    vTaskDelay(1);
+  }
+
+  retainedRecord current[MAX_RETAINED];
+  uint8_t count = captureRetained(current);
+  persistStats.retained = count;
+  bool ok = true;
+  if (count == writtenCount &&
+      memcmp(current, written, count * sizeof(retainedRecord)) == 0) {
+    persistStats.skipped++;
+  } else {
+    int64_t startUs = esp_timer_get_time();
+    Preferences prefs;
+    size_t length = count * sizeof(retainedRecord);
+    if (!prefs.begin(PERSIST_NAMESPACE, false)) {
+      ok = false;
+    } else if (count == 0) {
+      ok = !prefs.isKey(PERSIST_KEY) || prefs.remove(PERSIST_KEY);
+    } else {
+      ok = prefs.putBytes(PERSIST_KEY, current, length) == length;
+    }
+    prefs.end();
+    uint32_t us = (uint32_t)(esp_timer_get_time() - startUs);
+    persistStats.lastWriteUs = us;
+    if (us > persistStats.maxWriteUs) persistStats.maxWriteUs = us;
+    if (ok) {
+      persistStats.writes++;
+      memcpy(written, current, length);
+      writtenCount = count;
+    } else {
+      persistStats.failures++;
+      Serial.println("Retained values: NVS write failed");
+    }
+  }
+
+  flushing.store(false, std::memory_order_release);
+  return ok;
+}
+
+static void persistOnShutdown() { flushRetainedValues(); }
+
+static void persistTaskFunction(void *pvParameters) {
+  for (;;) {
+    uint16_t intervalS = constrain(defaultConfig.persistIntervalS,
+                                   MIN_PERSIST_INTERVAL_S,
+                                   MAX_PERSIST_INTERVAL_S);
+    vTaskDelay(pdMS_TO_TICKS((uint32_t)intervalS * 1000));
+    flushRetainedValues();
+  }
+}
+
+void startPersistence() {
+  persistStats.restored = restoreRetainedValues();
+  // What was just restored is what NVS holds; no write until it changes
+  writtenCount = captureRetained(written);
+  persistStats.retained = writtenCount;
+  Serial.printf("Retained values: %u restored, %u retained\n",
+                persistStats.restored, persistStats.retained);
+
+  if (persistTask != NULL) return;
+  esp_register_shutdown_handler(persistOnShutdown);
+  xTaskCreatePinnedToCore(persistTaskFunction, "persistTask",
+                          PERSIST_TASK_STACK, NULL, PERSIST_TASK_PRIORITY,
+                          &persistTask, PERSIST_TASK_CORE);
+}
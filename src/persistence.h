@@ -0,0 +1,53 @@
+#ifndef PERSISTENCE_H
+#define PERSISTENCE_H
+
+#include <Arduino.h>
+
+#include "dataStructure.h"
+
+// Retained runtime values in NVS. SoftIOs in 'persistent' mode keep their
+// value, state and flag across reboots; Timers keep their preset, which
+// setValue/increment actions can change at runtime.
+//
+// The scan task never touches flash: a low-priority task compares the
+// retained fields against what was last written every persistInterval
+// seconds and stores them as one blob only if something changed, so a
+// counter stepping every scan costs one NVS write per interval. The
+// shutdown hook (esp_restart) writes any pending change; a brownout resets
+// without warning, so at most one interval of changes is lost.
+
+#define DEFAULT_PERSIST_INTERVAL_S 60
+#define MIN_PERSIST_INTERVAL_S 5
+#define MAX_PERSIST_INTERVAL_S 3600
+
+#define PERSIST_NAMESPACE "retain"
+#define PERSIST_KEY "image"
+#define MAX_RETAINED (MAX_SOFTIO + MAX_TIMERS)
+
+#define PERSIST_TASK_CORE 0  // Next to the network task, away from the scan
+#define PERSIST_TASK_PRIORITY 1
+#define PERSIST_TASK_STACK 4096
+
+struct persistStatistics {
+  uint32_t writes;       // Blobs written to NVS
+  uint32_t skipped;      // Intervals with nothing changed
+  uint32_t failures;     // Failed NVS writes
+  uint32_t lastWriteUs;  // Duration of the last NVS write
+  uint32_t maxWriteUs;   // Longest NVS write seen
+  uint8_t retained;      // Slots currently retained
+  uint8_t restored;      // Slots restored at boot
+};
+
+extern persistStatistics persistStats;
+
+bool isRetained(const IOVariable &io);
+
+// Restores retained values into IOVariables and starts the writer task.
+// Call after the configuration is loaded and before startScanEngine().
+void startPersistence();
+
+// Writes the retained values now if they changed since the last write
+// (any task except the scan task). Returns false if the NVS write failed.
+bool flushRetainedValues();
+
+#endif  // PERSISTENCE_H
@@ -0,0 +1,91 @@
+#include "processImage.h"
+
+#include <atomic>
+
+#include "spscRing.h"
+
+processImageStatistics processImageStats;
+
+// images[published & 1] is the front buffer. 'started' runs one ahead of
+// 'published' while the scan task fills the back buffer.
+static processImage images[2];
+static std::atomic<uint32_t> published(0);
+static std::atomic<uint32_t> started(0);
+
+// Every web producer runs on async_tcp today; the lock keeps the ring
+// single-producer for any other task that queues commands
+static spscRing<ioCommand, IO_COMMAND_QUEUE> commandQueue;
+static portMUX_TYPE queueLock = portMUX_INITIALIZER_UNLOCKED;
+
+// --- Published Image ---
+void publishProcessImage(uint32_t cycle) {
+  uint32_t seq = published.load(std::memory_order_relaxed) + 1;
+  started.store(seq, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  processImage &back = images[seq & 1];
+  back.cycle = cycle;
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    const IOVariable &io = IOVariables[i];
+    back.io[i].value = io.value;
+    back.io[i].state = io.state;
+    back.io[i].flag = io.flag;
+  }
+  published.store(seq, std::memory_order_release);
+  processImageStats.published++;
+}
+
+bool readProcessImage(processImage &image) {
+  for (;;) {
+    uint32_t seq = published.load(std::memory_order_acquire);
+    if (seq == 0) return false;
+    memcpy(&image, &images[seq & 1], sizeof(image));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // This buffer is written again only from image seq + 2 on
+    if (started.load(std::memory_order_relaxed) - seq < 2) return true;
+    processImageStats.readRetries++;
+  }
+}
+// --- End Published Image ---
+
+// --- Command Queue ---
+bool isWritableField(const IOVariable &io, ioCommandField field) {
+  if (!io.status) return false;
+  if (io.type == SoftIO) return true;
+  if (io.type == DigitalOutput) return field == IO_FIELD_STATE;
+  if (io.type == Timer) return field == IO_FIELD_VALUE;
+  return false;  // Inputs and schedules are overwritten every scan
+}
+
+bool queueIOCommand(const ioCommand &command) {
+  portENTER_CRITICAL(&queueLock);
+  bool queued = commandQueue.push(command);
+  portEXIT_CRITICAL(&queueLock);
+  if (!queued) processImageStats.commandsDropped++;
+  return queued;
+}
+
+uint16_t ioCommandSpace() {
+  return IO_COMMAND_QUEUE - 1 - commandQueue.size();
+}
+
+// The rule pass picks the changes up like latched inputs (event, dirty
+// conditions); with the program stopped outputs still follow them
+void applyIOCommands() {
+  ioCommand command;
+  while (commandQueue.pop(command)) {
+    IOVariable &io = IOVariables[command.slot];
+    if (!isWritableField(io, command.field)) {  // Image swapped meanwhile
+      processImageStats.commandsRejected++;
+      continue;
+    }
+    if (command.field == IO_FIELD_STATE) {
+      io.state = command.value != 0;
+    } else if (command.field == IO_FIELD_VALUE) {
+      io.value = command.value;
+    } else {
+      io.flag = command.value != 0;
+    }
+    processImageStats.commandsApplied++;
+  }
+}
+// --- End Command Queue ---
@@ -0,0 +1,62 @@
+#ifndef PROCESS_IMAGE_H
+#define PROCESS_IMAGE_H
+
+#include <Arduino.h>
+
+#include "dataStructure.h"
+
+// Runtime fields of the IOVariables as other tasks see them. The scan task
+// writes them into the back one of two buffers after each output commit and
+// flips the published index; readers copy the front buffer and retry only
+// if the scan task started overwriting it meanwhile (a copy taking longer
+// than a scan period). Neither side ever blocks the other.
+//
+// Writes from the web and Modbus go the other way: they are queued as
+// commands and the scan task applies them at the start of its next cycle,
+// before rule evaluation, so a scan never sees a half-applied change
+// (POST /io in configApi.h, modbusProtocol.h).
+
+#define IO_COMMAND_QUEUE 32  // Power of two; one entry stays free
+
+struct processEntry {
+  int32_t value;
+  bool state;
+  bool flag;
+};
+
+struct processImage {
+  uint32_t cycle;  // scanStats.cycles when published
+  processEntry io[MAX_IO_VARIABLES];
+};
+
+enum ioCommandField : uint8_t { IO_FIELD_STATE, IO_FIELD_VALUE, IO_FIELD_FLAG };
+
+struct ioCommand {
+  uint8_t slot;
+  ioCommandField field;
+  int32_t value;
+};
+
+struct processImageStatistics {
+  uint32_t published;         // Images published by the scan task
+  uint32_t readRetries;       // Snapshots copied again after an overwrite
+  uint32_t commandsApplied;   // Commands applied at a scan boundary
+  uint32_t commandsDropped;   // Refused because the queue was full
+  uint32_t commandsRejected;  // Slot no longer writable when applied
+};
+
+extern processImageStatistics processImageStats;
+
+void publishProcessImage(uint32_t cycle);  // Scan task, after the commit
+// Any task. False until the scan task has published its first image.
+bool readProcessImage(processImage &image);
+
+// SoftIO: any field; DigitalOutput: state; Timer: value (preset)
+bool isWritableField(const IOVariable &io, ioCommandField field);
+bool queueIOCommand(const ioCommand &command);  // Any task; false if full
+// Commands that fit before queueIOCommand() fails; exact only for the
+// task that does all the queueing (async_tcp)
+uint16_t ioCommandSpace();
+void applyIOCommands();  // Scan task, before rule evaluation
+
+#endif  // PROCESS_IMAGE_H
@@ -0,0 +1,286 @@
+#include "ruleEngine.h"
+
+#define NOT_COMPILED LOGIC_ID_NONE
+
+// Scratch space of compileRuleProgram. Like the spare program, only one
+// compile runs at a time (boot, then the config POST handler); keeping it
+// off the stack lets the large profile compile on small task stacks.
+struct compilerScratch {
+  logicId conditionIndex[MAX_CONDITIONS + 1];  // conNum -> compiled index
+  bool conditionResolved[MAX_CONDITIONS + 1];  // conditionIndex is final
+  bool ruleEmitted[MAX_RULES];
+  // (condition, compiled rule) pairs for the reverse dependency index
+  logicId readCondition[MAX_CONDITION_READS];
+  logicId readRule[MAX_CONDITION_READS];
+  uint16_t conditionFill[MAX_CONDITIONS];
+};
+
+static compilerScratch scratch;
+
+// --- Lookup Helpers (IDs are 1-based 'num' values, 0 means unused) ---
+// Only used while compiling; the compiled program holds direct indexes.
+static int16_t findConditionGroup(logicId num) {
+  if (num == 0) return -1;
+  for (logicId i = 0; i < MAX_CONDITION_GROUPS; i++) {
+    if (conditionGroups[i].num == num && conditionGroups[i].status) return i;
+  }
+  return -1;
+}
+
+static int16_t findActionGroup(logicId num) {
+  if (num == 0) return -1;
+  for (logicId i = 0; i < MAX_ACTION_GROUPS; i++) {
+    if (actionGroups[i].num == num && actionGroups[i].status) return i;
+  }
+  return -1;
+}
+
+static int16_t findRule(logicId num) {
+  if (num == 0) return -1;
+  for (logicId i = 0; i < MAX_RULES; i++) {
+    if (rules[i].num == num && rules[i].status) return i;
+  }
+  return -1;
+}
+
+static int16_t findAction(logicId actNum) {
+  if (actNum == 0) return -1;
+  for (logicId i = 0; i < MAX_ACTIONS; i++) {
+    if (actions[i].actNum == actNum && actions[i].status) return i;
+  }
+  return -1;
+}
+
+// Resolves an enabled IOVariable, -1 if missing or disabled
+static int16_t findEnabledSlot(const IOVariable *image, dataTypes type,
+                               uint8_t num) {
+  int16_t slot = findIOVariableSlot(type, num, image);
+  if (slot < 0 || !image[slot].status) return -1;
+  return slot;
+}
+// --- End Lookup Helpers ---
+
+// Compiled index of condition 'conNum', NOT_COMPILED if unused, disabled or
+// dangling. Conditions are compiled on first use, so the members of a group
+// usually share one result word and conditions no rule reads cost nothing.
+static logicId useCondition(ruleProgram &program, const IOVariable *image,
+                            logicId conNum) {
+  if (conNum == 0 || conNum > MAX_CONDITIONS) return NOT_COMPILED;
+  logicId &index = scratch.conditionIndex[conNum];
+  if (scratch.conditionResolved[conNum]) return index;
+  scratch.conditionResolved[conNum] = true;
+  for (logicId i = 0; i < MAX_CONDITIONS; i++) {
+    const condition &cond = conditions[i];
+    if (!cond.status || cond.conNum != conNum) continue;
+    int16_t slot = findEnabledSlot(image, cond.Type, cond.targetNum);
+    if (slot < 0) continue;  // A later duplicate may still resolve
+    logicId c = program.conditionCount++;
+    compiledCondition &cc = program.conditions[c];
+    cc.slot = slot;
+    cc.comp = cond.comp;
+    cc.value = cond.value;
+    if (cond.comp == isFalse || cond.comp == flagIsFalse) {
+      program.invertMask[c / 32] |= 1u << (c % 32);
+    }
+    index = c;
+    break;
+  }
+  return index;
+}
+
+// Maps an action onto a specialised opcode for its target type and mode.
+// Returns false for combinations that have no effect (e.g. set on an input).
+static bool selectActionOpcode(const action &act, const IOVariable &io,
+                               opCode &op) {
+  if (act.action == setFlag) {
+    op = OP_SETFLAG;
+    return true;
+  }
+  if (io.type == DigitalInput || io.type == AnalogInput ||
+      io.type == Schedule) {
+    op = OP_CLRFLAG;
+    return act.action == clear;  // Owned by the input latch / scheduler
+  }
+  switch (act.action) {
+    case set:
+      if (io.type == Timer) {
+        op = OP_TSTART;
+      } else if (io.type == DigitalOutput && io.mode == startDelay) {
+        op = OP_DELAYON;
+      } else if (io.type == DigitalOutput && io.mode == autoOff) {
+        op = OP_PULSE;
+      } else {
+        op = OP_SET;
+      }
+      return true;
+    case reset:
+      op = OP_RESET;
+      return true;
+    case setValue:
+      op = OP_SETVAL;
+      return true;
+    case increment:
+      op = OP_INC;
+      return true;
+    case decrement:
+      op = OP_DEC;
+      return true;
+    case clear:
+      op = (io.type == Timer) ? OP_TCLEAR : OP_CLRFLAG;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static void emit(ruleProgram &program, opCode op, logicId arg,
+                 int32_t operand) {
+  instruction &ins = program.code[program.length++];
+  ins.op = op;
+  ins.arg = arg;
+  ins.operand = operand;
+}
+
+// One mask test per condition word the members occupy, AND or OR combined
+static void emitConditionMasks(ruleProgram &program, const logicId *members,
+                               uint8_t count, bool all) {
+  bool covered[MAX_CONDITIONS_PER_GROUP] = {};
+  bool first = true;
+  for (uint8_t i = 0; i < count; i++) {
+    if (covered[i]) continue;
+    logicId word = members[i] / 32;
+    uint32_t mask = 0;
+    for (uint8_t j = i; j < count; j++) {
+      if (members[j] / 32 != word) continue;
+      mask |= 1u << (members[j] % 32);
+      covered[j] = true;
+    }
+    opCode op = all ? (first ? OP_ALL : OP_ANDALL)
+                    : (first ? OP_ANY : OP_ORANY);
+    emit(program, op, word, (int32_t)mask);
+    first = false;
+  }
+}
+
+// Emits the action for 'actNum'; returns false if nothing was emitted
+static bool emitAction(ruleProgram &program, const IOVariable *image,
+                       logicId actNum) {
+  int16_t index = findAction(actNum);
+  if (index < 0) return false;
+  const action &act = actions[index];
+  int16_t slot = findEnabledSlot(image, act.Type, act.targetNum);
+  if (slot < 0) return false;
+  opCode op;
+  if (!selectActionOpcode(act, image[slot], op)) return false;
+  emit(program, op, slot, act.value);
+  return true;
+}
+
+void compileRuleProgram(ruleProgram &program, const IOVariable *image) {
+  bool *ruleEmitted = scratch.ruleEmitted;
+  logicId *readCondition = scratch.readCondition;
+  logicId *readRule = scratch.readRule;
+  memset(scratch.conditionIndex, 0xFF, sizeof(scratch.conditionIndex));
+  memset(scratch.conditionResolved, 0, sizeof(scratch.conditionResolved));
+  memset(ruleEmitted, 0, sizeof(scratch.ruleEmitted));
+  uint16_t readCount = 0;
+
+  program.conditionCount = 0;
+  program.ruleCount = 0;
+  program.length = 0;
+  memset(program.invertMask, 0, sizeof(program.invertMask));
+
+  // --- Rules in execution order ---
+  for (uint8_t s = 0; s < MAX_RULES; s++) {
+    int16_t r = findRule(ruleSequence[s]);
+    if (r < 0 || ruleEmitted[r]) continue;
+    const rule &ru = rules[r];
+    uint16_t start = program.length;
+    uint16_t readStart = readCount;
+
+    // Condition source -> ALL|ANY [ANDALL|ORANY ...]
+    logicId members[MAX_CONDITIONS_PER_GROUP];
+    uint8_t loaded = 0;
+    bool all = true;
+    if (ru.useConditionGroup) {
+      int16_t g = findConditionGroup(ru.conditionSourceId);
+      if (g >= 0) {
+        all = conditionGroups[g].Logic == andLogic;
+        for (uint8_t j = 0; j < MAX_CONDITIONS_PER_GROUP; j++) {
+          logicId ci = useCondition(program, image,
+                                    conditionGroups[g].conditionArray[j]);
+          if (ci != NOT_COMPILED) members[loaded++] = ci;
+        }
+      }
+    } else {
+      logicId ci = useCondition(program, image, ru.conditionSourceId);
+      if (ci != NOT_COMPILED) members[loaded++] = ci;
+    }
+    if (loaded == 0) continue;  // Rule can never be true
+    emitConditionMasks(program, members, loaded, all);
+    for (uint8_t j = 0; j < loaded; j++) {
+      readCondition[readCount] = members[j];
+      readRule[readCount++] = program.ruleCount;
+    }
+
+    emit(program, OP_EDGE, program.ruleCount, 0);
+    uint16_t jump = program.length;
+    emit(program, OP_JMPF, 0, 0);
+
+    // Action target -> one instruction per effective action
+    uint8_t emitted = 0;
+    if (ru.useActionGroup) {
+      int16_t g = findActionGroup(ru.actionTargetId);
+      if (g >= 0) {
+        for (uint8_t j = 0; j < MAX_ACTIONS_PER_GROUP; j++) {
+          if (emitAction(program, image, actionGroups[g].actionArray[j])) {
+            emitted++;
+          }
+        }
+      }
+    } else if (emitAction(program, image, ru.actionTargetId)) {
+      emitted++;
+    }
+    if (emitted == 0) {  // Rule has no observable effect
+      program.length = start;
+      readCount = readStart;
+      continue;
+    }
+
+    program.code[jump].operand = program.length;
+    program.ruleNum[program.ruleCount] = ru.num;
+    program.ruleEntry[program.ruleCount++] = start;
+    ruleEmitted[r] = true;
+  }
+
+  program.ruleEntry[program.ruleCount] = program.length;
+  emit(program, OP_END, 0, 0);
+
+  // --- Reverse dependency index (counting sort into compressed rows) ---
+  memset(program.slotConditionStart, 0, sizeof(program.slotConditionStart));
+  for (logicId c = 0; c < program.conditionCount; c++) {
+    program.slotConditionStart[program.conditions[c].slot + 1]++;
+  }
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    program.slotConditionStart[i + 1] += program.slotConditionStart[i];
+  }
+  logicId slotFill[MAX_IO_VARIABLES];
+  memcpy(slotFill, program.slotConditionStart, sizeof(slotFill));
+  for (logicId c = 0; c < program.conditionCount; c++) {
+    program.slotConditions[slotFill[program.conditions[c].slot]++] = c;
+  }
+
+  memset(program.conditionRuleStart, 0, sizeof(program.conditionRuleStart));
+  for (uint16_t k = 0; k < readCount; k++) {
+    program.conditionRuleStart[readCondition[k] + 1]++;
+  }
+  for (logicId c = 0; c < MAX_CONDITIONS; c++) {
+    program.conditionRuleStart[c + 1] += program.conditionRuleStart[c];
+  }
+  uint16_t *conditionFill = scratch.conditionFill;
+  memcpy(conditionFill, program.conditionRuleStart,
+         sizeof(scratch.conditionFill));
+  for (uint16_t k = 0; k < readCount; k++) {
+    program.conditionRules[conditionFill[readCondition[k]]++] = readRule[k];
+  }
+}
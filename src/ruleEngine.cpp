@@ -0,0 +1,331 @@
+#include "ruleEngine.h"
+
+#include "eventRing.h"
+#include "timerService.h"
+
+static ruleProgram programImages[2];
+ruleProgram *activeProgram = &programImages[0];
+ruleEngineStatistics ruleEngineStats;
+ruleEngineProfile ruleProfile;
+
+// Runtime fields of an IOVariable as last seen by the dependency tracking
+struct ioShadow {
+  bool state;
+  int32_t value;
+  bool flag;
+};
+
+// --- Runtime State (not part of the saved configuration) ---
+static bool ruleMemory[MAX_RULES];  // Condition result of each compiled rule
+static bool ruleDirty[MAX_RULES];   // Rule must be re-evaluated
+// One bit per compiled condition: raw result (before the invert mask) and
+// whether it is stale
+static uint32_t conditionRaw[CONDITION_WORDS];
+static uint32_t conditionDirty[CONDITION_WORDS];
+static ioShadow shadow[MAX_IO_VARIABLES];
+static logicId executingRuleNum = 0;  // Source 'num' of the running rule
+// Last AnalogInput value put in the event ring, and when
+static int32_t analogEventValue[MAX_ANALOG_IN];
+static uint32_t analogEventMs[MAX_ANALOG_IN];
+// ==============================================================
+
+// Invalidates every condition reading 'slot' and every rule reading those
+static void markSlotDirty(uint8_t slot) {
+  const ruleProgram &program = *activeProgram;
+  for (logicId k = program.slotConditionStart[slot];
+       k < program.slotConditionStart[slot + 1]; k++) {
+    logicId c = program.slotConditions[k];
+    conditionDirty[c / 32] |= 1u << (c % 32);
+    for (uint16_t m = program.conditionRuleStart[c];
+         m < program.conditionRuleStart[c + 1]; m++) {
+      ruleDirty[program.conditionRules[m]] = true;
+    }
+  }
+}
+
+static void syncShadow(uint8_t slot) {
+  shadow[slot].state = IOVariables[slot].state;
+  shadow[slot].value = IOVariables[slot].value;
+  shadow[slot].flag = IOVariables[slot].flag;
+}
+
+// Writes made by actions notify dependents immediately, so rules later in
+// the sequence see them in the same pass and earlier ones in the next.
+static void writeState(uint8_t slot, bool state) {
+  if (IOVariables[slot].state == state) return;
+  recordEvent(EVENT_STATE, slot, executingRuleNum, !state, state);
+  IOVariables[slot].state = state;
+  syncShadow(slot);
+  markSlotDirty(slot);
+}
+
+static void writeValue(uint8_t slot, int32_t value) {
+  if (IOVariables[slot].value == value) return;
+  recordEvent(EVENT_VALUE, slot, executingRuleNum, IOVariables[slot].value,
+              value);
+  IOVariables[slot].value = value;
+  syncShadow(slot);
+  markSlotDirty(slot);
+}
+
+static void writeFlag(uint8_t slot, bool flag) {
+  if (IOVariables[slot].flag == flag) return;
+  recordEvent(EVENT_FLAG, slot, executingRuleNum, !flag, flag);
+  IOVariables[slot].flag = flag;
+  syncShadow(slot);
+  markSlotDirty(slot);
+}
+
+// Starts the deadline of a Timer or delayed DO from its 'value' in ms
+static void startDeadline(uint8_t slot) {
+  const IOVariable &io = IOVariables[slot];
+  uint64_t delayUs = io.value > 0 ? (uint64_t)io.value * 1000 : 0;
+  uint64_t periodUs = (io.type == Timer && io.mode == repeating) ? delayUs : 0;
+  timerStart(slot, delayUs, periodUs);
+}
+
+// Forces the next pass to evaluate everything against the current image
+static void invalidateAll() {
+  for (uint8_t i = 0; i < MAX_RULES; i++) {
+    ruleDirty[i] = true;
+  }
+  for (logicId w = 0; w < CONDITION_WORDS; w++) {
+    conditionDirty[w] = ~0u;
+  }
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    syncShadow(i);
+  }
+  // Events continue from the current readings; the first change that
+  // passes the deadband is recorded at once
+  uint32_t nowMs = millis();
+  for (uint8_t a = 0; a < MAX_ANALOG_IN; a++) {
+    analogEventValue[a] = IOVariables[FIRST_ANALOG_IN + a].value;
+    analogEventMs[a] = nowMs - ANALOG_EVENT_INTERVAL_MS;
+  }
+}
+
+// Records AnalogInput values that left the deadband of the last recorded
+// one, once per ANALOG_EVENT_INTERVAL_MS at most. A value held back by the
+// interval is recorded when it runs out, even without a further change.
+static void recordAnalogEvents() {
+  uint32_t nowMs = millis();
+  for (uint8_t a = 0; a < MAX_ANALOG_IN; a++) {
+    const IOVariable &io = IOVariables[FIRST_ANALOG_IN + a];
+    if (!io.status || io.type != AnalogInput) continue;
+    int32_t band = (io.mode == scaled) ? ANALOG_EVENT_DEADBAND_SCALED
+                                       : ANALOG_EVENT_DEADBAND;
+    if (abs(io.value - analogEventValue[a]) < band) continue;
+    if (nowMs - analogEventMs[a] < ANALOG_EVENT_INTERVAL_MS) continue;
+    recordEvent(EVENT_VALUE, FIRST_ANALOG_IN + a, 0, analogEventValue[a],
+                io.value);
+    analogEventValue[a] = io.value;
+    analogEventMs[a] = nowMs;
+  }
+}
+
+ruleProgram *spareProgram() {
+  return activeProgram == &programImages[0] ? &programImages[1]
+                                            : &programImages[0];
+}
+
+void resetRuleEngine() {
+  resetTimerService();
+  for (uint8_t i = 0; i < MAX_RULES; i++) {
+    ruleMemory[i] = false;
+  }
+  invalidateAll();
+  ruleEngineStats.totalRuleEvals = 0;
+  memset(&ruleProfile, 0, sizeof(ruleProfile));
+}
+
+void swapRuleProgram(ruleProgram *next) {
+  bool memory[MAX_RULES];
+  for (logicId r = 0; r < next->ruleCount; r++) {
+    memory[r] = false;
+    for (logicId q = 0; q < activeProgram->ruleCount; q++) {
+      if (activeProgram->ruleNum[q] == next->ruleNum[r]) {
+        memory[r] = ruleMemory[q];
+        break;
+      }
+    }
+  }
+  activeProgram = next;
+  memcpy(ruleMemory, memory, next->ruleCount * sizeof(bool));
+  memset(&ruleProfile, 0, sizeof(ruleProfile));  // Indexes changed meaning
+  invalidateAll();
+}
+
+void applyTimerExpirations() {
+  for (uint8_t w = 0; w < TIMER_MASK_WORDS; w++) {
+    uint32_t expired = takeExpiredTimers(w);
+    while (expired != 0) {
+      uint8_t bit = __builtin_ctz(expired);
+      expired &= expired - 1;
+      IOVariable &io = IOVariables[w * 32 + bit];
+      if (io.type == Timer) {
+        io.flag = true;  // Expired; repeating Timers keep running
+        if (io.mode != repeating) io.state = false;
+      } else if (io.type == DigitalOutput) {
+        // startDelay turns the output on, autoOff turns it off
+        io.state = (io.mode == startDelay);
+      }
+    }
+  }
+}
+
+// Raw bit of a condition; the invert mask completes isFalse / flagIsFalse
+static bool sampleCondition(const compiledCondition &cond) {
+  const IOVariable &io = IOVariables[cond.slot];
+  switch (cond.comp) {
+    case isTrue:
+    case isFalse:
+      return io.state;
+    case flagIsTrue:
+    case flagIsFalse:
+      return io.flag;
+    case isEqual:
+      return io.value == cond.value;
+    case isLess:
+      return io.value < cond.value;
+    case isGreater:
+      return io.value > cond.value;
+  }
+  return false;
+}
+
+// Results of the conditions in 'mask' of word 'w'; stale bits are sampled
+// again first, the others come from the cache
+static uint32_t readConditions(logicId w, uint32_t mask) {
+  uint32_t stale = conditionDirty[w] & mask;
+  if (stale != 0) {
+    const compiledCondition *word = &activeProgram->conditions[w * 32];
+    uint32_t raw = conditionRaw[w] & ~stale;
+    conditionDirty[w] &= ~stale;
+    while (stale != 0) {
+      uint8_t bit = __builtin_ctz(stale);
+      stale &= stale - 1;
+      if (sampleCondition(word[bit])) raw |= 1u << bit;
+      ruleEngineStats.conditionEvals++;
+    }
+    conditionRaw[w] = raw;
+  }
+  return (conditionRaw[w] ^ activeProgram->invertMask[w]) & mask;
+}
+
+// Runs the instructions of one compiled rule, [pc, end)
+static void executeRule(uint16_t pc, uint16_t end) {
+  const ruleProgram &program = *activeProgram;
+  bool acc = false;
+  while (pc < end) {
+    const instruction &ins = program.code[pc++];
+    switch (ins.op) {
+      case OP_ALL:
+        acc = readConditions(ins.arg, ins.operand) == (uint32_t)ins.operand;
+        break;
+      case OP_ANDALL:
+        acc = acc &&
+              readConditions(ins.arg, ins.operand) == (uint32_t)ins.operand;
+        break;
+      case OP_ANY:
+        acc = readConditions(ins.arg, ins.operand) != 0;
+        break;
+      case OP_ORANY:
+        acc = acc || readConditions(ins.arg, ins.operand) != 0;
+        break;
+      case OP_EDGE: {
+        bool previous = ruleMemory[ins.arg];
+        ruleMemory[ins.arg] = acc;
+        acc = acc && !previous;
+        if (acc) recordEvent(EVENT_RULE, EVENT_NO_SLOT, executingRuleNum, 0, 0);
+        break;
+      }
+      case OP_JMPF:
+        if (!acc) pc = (uint16_t)ins.operand;
+        break;
+      case OP_SET:
+        writeState(ins.arg, true);
+        break;
+      case OP_RESET:
+        writeState(ins.arg, false);
+        timerStop(ins.arg);
+        break;
+      case OP_SETVAL:
+        writeValue(ins.arg, ins.operand);
+        break;
+      case OP_INC:
+        writeValue(ins.arg, IOVariables[ins.arg].value + ins.operand);
+        break;
+      case OP_DEC:
+        writeValue(ins.arg, IOVariables[ins.arg].value - ins.operand);
+        break;
+      case OP_SETFLAG:
+        writeFlag(ins.arg, true);
+        break;
+      case OP_CLRFLAG:
+        writeFlag(ins.arg, false);
+        break;
+      case OP_TSTART:
+        writeState(ins.arg, true);
+        writeFlag(ins.arg, false);
+        startDeadline(ins.arg);
+        break;
+      case OP_TCLEAR:
+        writeState(ins.arg, false);
+        writeFlag(ins.arg, false);
+        timerStop(ins.arg);
+        break;
+      case OP_DELAYON:
+        startDeadline(ins.arg);
+        break;
+      case OP_PULSE:
+        writeState(ins.arg, true);
+        startDeadline(ins.arg);
+        break;
+      case OP_END:
+      default:
+        return;
+    }
+  }
+}
+
+void runRuleProgram() {
+  const ruleProgram &program = *activeProgram;
+  ruleEngineStats.changedSlots = 0;
+  ruleEngineStats.conditionEvals = 0;
+  ruleEngineStats.ruleEvals = 0;
+
+  // Changes made outside the program: input latch, timer expiries, web
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    const IOVariable &io = IOVariables[i];
+    if (io.state == shadow[i].state && io.value == shadow[i].value &&
+        io.flag == shadow[i].flag) {
+      continue;
+    }
+    if (io.state != shadow[i].state) {
+      recordEvent(EVENT_STATE, i, 0, shadow[i].state, io.state);
+    }
+    if (io.value != shadow[i].value && io.type != AnalogInput) {
+      recordEvent(EVENT_VALUE, i, 0, shadow[i].value, io.value);
+    }
+    if (io.flag != shadow[i].flag) {
+      recordEvent(EVENT_FLAG, i, 0, shadow[i].flag, io.flag);
+    }
+    syncShadow(i);
+    markSlotDirty(i);
+    ruleEngineStats.changedSlots++;
+  }
+  recordAnalogEvents();
+
+  for (logicId r = 0; r < program.ruleCount; r++) {
+    if (!ruleDirty[r]) continue;
+    ruleDirty[r] = false;
+    ruleEngineStats.ruleEvals++;
+    uint32_t startCycles = ESP.getCycleCount();
+    executingRuleNum = program.ruleNum[r];
+    executeRule(program.ruleEntry[r], program.ruleEntry[r + 1]);
+    ruleProfile.cycles[r] += ESP.getCycleCount() - startCycles;
+    ruleProfile.evals[r]++;
+  }
+  executingRuleNum = 0;
+  ruleEngineStats.totalRuleEvals += ruleEngineStats.ruleEvals;
+}
@@ -0,0 +1,131 @@
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <Arduino.h>
+
+#include "dataStructure.h"
+
+// The rule engine runs a compiled form of rules[] against the runtime fields
+// of IOVariables[]. It has no knowledge of GPIOs or tasks; the scan engine
+// latches inputs before and commits outputs after each pass.
+//
+// Rules are edge triggered: a rule executes its action source once when its
+// condition source changes from false to true, like a relay contact closing.
+// Evaluation is incremental: condition results are cached and only the
+// conditions reading a changed IOVariable, and the rules consuming those
+// conditions, are recomputed in a pass. Each change of a runtime field and
+// each rule firing is put in the event ring (eventRing.h), except that
+// AnalogInput values are recorded only after moving by the deadband from
+// the last recorded value, at most once per ANALOG_EVENT_INTERVAL_MS per
+// input. Rules still see every change; the limit keeps ADC noise from
+// filling the flash.
+//
+// Condition results are packed 32 to a word (the native width of the
+// ESP32), and a condition source reads a whole word at once: a group is one
+// mask test per word it spans, whatever its size. Boolean conditions store
+// the raw state/flag bit and the program's invert mask turns it into the
+// isFalse/flagIsFalse result; only numeric comparisons need a compare.
+
+// Worst case: every rule has a full condition and action group plus its
+// EDGE and JMPF instructions, followed by a single END.
+#define MAX_PROGRAM_SIZE \
+  (MAX_RULES * (MAX_CONDITIONS_PER_GROUP + MAX_ACTIONS_PER_GROUP + 2) + 1)
+#define MAX_CONDITION_READS (MAX_RULES * MAX_CONDITIONS_PER_GROUP)
+#define CONDITION_WORDS ((MAX_CONDITIONS + 31) / 32)
+
+#define ANALOG_EVENT_DEADBAND 16        // Raw 12-bit counts (0.4 %)
+#define ANALOG_EVENT_DEADBAND_SCALED 2  // Percent, 'scaled' mode
+#define ANALOG_EVENT_INTERVAL_MS 1000
+
+// --- Compiled Program ---
+enum opCode : uint8_t {
+  OP_ALL,      // acc = every condition in mask operand of word arg holds
+  OP_ANDALL,   // acc = acc && OP_ALL
+  OP_ANY,      // acc = any condition in mask operand of word arg holds
+  OP_ORANY,    // acc = acc || OP_ANY
+  OP_EDGE,     // acc = rising edge of acc, memory in ruleMemory[arg]
+  OP_JMPF,     // if !acc jump to operand
+  OP_SET,      // IOVariables[arg].state = true
+  OP_RESET,    // IOVariables[arg].state = false, cancel pending deadline
+  OP_SETVAL,   // IOVariables[arg].value = operand
+  OP_INC,      // IOVariables[arg].value += operand
+  OP_DEC,      // IOVariables[arg].value -= operand
+  OP_SETFLAG,  // IOVariables[arg].flag = true
+  OP_CLRFLAG,  // IOVariables[arg].flag = false
+  OP_TSTART,   // (Re)start Timer arg for its preset 'value' ms
+  OP_TCLEAR,   // Stop Timer arg and clear its expired flag
+  OP_DELAYON,  // startDelay DO: switch on after 'value' ms
+  OP_PULSE,    // autoOff DO: switch on now, off after 'value' ms
+  OP_END
+};
+
+struct instruction {
+  opCode op;
+  logicId arg;      // IO slot, condition word or rule memory index
+  int32_t operand;  // Action value, condition mask or jump target
+};
+
+// A condition with its target already resolved to an IOVariables[] slot
+struct compiledCondition {
+  uint8_t slot;
+  comparisons comp;
+  int32_t value;
+};
+
+struct ruleProgram {
+  compiledCondition conditions[MAX_CONDITIONS];  // In order of first use
+  uint32_t invertMask[CONDITION_WORDS];  // isFalse / flagIsFalse bits
+  instruction code[MAX_PROGRAM_SIZE];
+  uint16_t ruleEntry[MAX_RULES + 1];  // First instruction of each rule,
+                                      // [ruleCount] is the final OP_END
+  logicId ruleNum[MAX_RULES];         // Source rule 'num' of each rule
+  // Reverse dependency index (compressed rows): conditions reading each IO
+  // slot, and compiled rules reading each condition
+  logicId slotConditionStart[MAX_IO_VARIABLES + 1];
+  logicId slotConditions[MAX_CONDITIONS];
+  uint16_t conditionRuleStart[MAX_CONDITIONS + 1];
+  logicId conditionRules[MAX_CONDITION_READS];
+  logicId conditionCount;
+  logicId ruleCount;  // Rules emitted, one edge memory each
+  uint16_t length;    // Instructions including the final OP_END
+};
+
+// Work done by the last pass, to verify that idle scans stay near zero
+struct ruleEngineStatistics {
+  uint8_t changedSlots;     // IOVariables whose runtime fields changed
+  logicId conditionEvals;   // Conditions recomputed
+  logicId ruleEvals;        // Rules re-evaluated
+  uint32_t totalRuleEvals;  // Since the last reset
+};
+
+extern ruleEngineStatistics ruleEngineStats;
+
+// Per compiled rule of activeProgram, since it became active. Cycles come
+// from the CPU cycle counter (ESP.getCpuFreqMHz() per microsecond).
+struct ruleEngineProfile {
+  uint32_t evals[MAX_RULES];
+  uint32_t cycles[MAX_RULES];
+};
+
+extern ruleEngineProfile ruleProfile;
+
+// Two program images: one executing, one spare for the next configuration
+extern ruleProgram *activeProgram;
+ruleProgram *spareProgram();
+// --- End Compiled Program ---
+
+// Resolves every ID in the global configuration arrays against the IO image
+// and emits a flat program. Disabled or dangling entries are dropped.
+void compileRuleProgram(ruleProgram &program,
+                        const IOVariable *image = IOVariables);
+
+// Makes 'next' the active program between scans (scan task only). Edge
+// memory carries over for rules with the same 'num', so a rule whose
+// condition is already true does not fire again because of the swap.
+void swapRuleProgram(ruleProgram *next);
+
+void resetRuleEngine();          // Clear timers, edge memory and caches
+void applyTimerExpirations();    // Apply expiries from the timer service
+void runRuleProgram();           // One pass over activeProgram
+
+#endif  // RULE_ENGINE_H
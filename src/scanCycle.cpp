@@ -0,0 +1,88 @@
+#include "scanCycle.h"
+
+#include <driver/gpio.h>
+
+#include "analogInput.h"
+#include "configJson.h"
+#include "inputCapture.h"
+#include "processImage.h"
+#include "ruleEngine.h"
+#include "scheduler.h"
+#include "timerService.h"
+
+static bool committedOutput[MAX_IO_VARIABLES];  // Level last written to pin
+
+// --- Input Latch / Output Commit ---
+void configurePin(uint8_t slot) {
+  IOVariable &io = IOVariables[slot];
+  if (!io.status) return;
+  if (io.type == DigitalInput) {
+    pinMode(io.gpio, INPUT);
+    io.state = digitalRead(io.gpio);  // No edge on the first scan
+  } else if (io.type == DigitalOutput) {
+    pinMode(io.gpio, OUTPUT);
+    digitalWrite(io.gpio, io.state ? HIGH : LOW);
+    committedOutput[slot] = io.state;
+  }
+}
+
+void configurePins() {
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    configurePin(i);
+  }
+}
+
+static void latchInputs(uint32_t nowUs) {
+  drainInputEdges(nowUs);
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    IOVariable &io = IOVariables[i];
+    if (!io.status) continue;
+    if (io.type == DigitalInput) {
+      // Edge modes come from the interrupt capture, which raises the flag
+      // for one scan per edge even if the pulse was shorter than a scan
+      if (isEdgeMode(io.mode)) io.flag = takeInputEdge(i, io.flag);
+      io.state = digitalRead(io.gpio);
+    } else if (io.type == AnalogInput) {
+      // ADC1 pins come filtered from the background acquisition
+      int32_t raw;
+      analogReading reading = readAnalogInput(io.gpio, raw);
+      if (reading == ANALOG_PENDING) continue;  // Hold the last value
+      if (reading == ANALOG_NOT_SAMPLED) raw = analogRead(io.gpio);
+      io.value = (io.mode == scaled) ? map(raw, 0, 4095, 0, 100) : raw;
+    }
+  }
+}
+
+// Actions only change IOVariables[].state during evaluation; every output
+// that changed this scan switches here, within a few bus cycles
+static void commitOutputs() {
+  uint64_t high = 0;
+  uint64_t low = 0;
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    const IOVariable &io = IOVariables[i];
+    if (!io.status || io.type != DigitalOutput) continue;
+    if (io.state == committedOutput[i]) continue;
+    if (GPIO_IS_VALID_OUTPUT_GPIO(io.gpio)) {  // Else no pin, as digitalWrite
+      if (io.state) {
+        high |= 1ULL << io.gpio;
+      } else {
+        low |= 1ULL << io.gpio;
+      }
+    }
+    committedOutput[i] = io.state;
+  }
+  if (high | low) writeOutputPins(high, low);
+}
+// --- End Input Latch / Output Commit ---
+
+void runScanCycle(int64_t startUs, uint32_t cycle) {
+  latchInputs((uint32_t)startUs);
+  runScheduler(startUs);  // Only compares the earliest deadline
+  applyIOCommands();      // Web writes queued since the last scan
+  if (defaultConfig.run) {
+    applyTimerExpirations();
+    runRuleProgram();
+  }
+  commitOutputs();
+  publishProcessImage(cycle);
+}
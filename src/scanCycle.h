@@ -0,0 +1,25 @@
+#ifndef SCAN_CYCLE_H
+#define SCAN_CYCLE_H
+
+#include <Arduino.h>
+
+#include "dataStructure.h"
+
+// The steps of one scan cycle, shared by the firmware scan task
+// (scanEngine.cpp) and the host simulator (sim/simScan.cpp), so both latch
+// inputs, evaluate and commit outputs the same way. Only writeOutputPins()
+// is platform code. All functions are scan task only.
+
+// Sets up the pin of 'slot' for the current IOVariables image
+void configurePin(uint8_t slot);
+void configurePins();
+
+// Input latch -> schedules -> queued writes -> rule evaluation (if the
+// program runs) -> output commit -> process image 'cycle', at 'startUs'
+void runScanCycle(int64_t startUs, uint32_t cycle);
+
+// Platform: drives the pins set in 'high' high and those in 'low' low
+// (bit n is GPIO n)
+void writeOutputPins(uint64_t high, uint64_t low);
+
+#endif  // SCAN_CYCLE_H
@@ -0,0 +1,174 @@
+#include "scanEngine.h"
+
+#include <esp_task_wdt.h>
+#include <esp_timer.h>
+#include <soc/gpio_struct.h>
+
+#include <atomic>
+
+#include "analogInput.h"
+#include "configJson.h"
+#include "eventRing.h"
+#include "inputCapture.h"
+#include "liveStream.h"
+#include "metrics.h"
+#include "ruleEngine.h"
+#include "scanCycle.h"
+#include "scheduler.h"
+#include "timerService.h"
+
+TaskHandle_t scanTask;
+scanStatistics scanStats;
+
+static std::atomic<bool> swapRequested(false);
+static TaskHandle_t swapWaiter = NULL;  // Notified once the swap is done
+
+static void scanTaskFunction(void *pvParameters);
+
+// Pins 0-31 and 32-39 have separate set/clear registers; writing 1 bits
+// changes only those pins, so no read-modify-write is needed
+void writeOutputPins(uint64_t high, uint64_t low) {
+  if ((uint32_t)high) GPIO.out_w1ts = (uint32_t)high;
+  if ((uint32_t)low) GPIO.out_w1tc = (uint32_t)low;
+  if (high >> 32) GPIO.out1_w1ts.val = (uint32_t)(high >> 32);
+  if (low >> 32) GPIO.out1_w1tc.val = (uint32_t)(low >> 32);
+}
+
+// --- Logic Image Swap ---
+// Same type, number, pin, mode and status: the slot keeps its runtime state
+static bool sameIdentity(const IOVariable &a, const IOVariable &b) {
+  return a.type == b.type && a.num == b.num && a.gpio == b.gpio &&
+         a.mode == b.mode && a.status == b.status;
+}
+
+// Switches to the spare IOVariables image and program between two scans
+static void switchLogicImage() {
+  IOVariable *previous = IOVariables;
+  IOVariable *next = spareIOVariables();
+  bool changed[MAX_IO_VARIABLES];
+  bool captureChanged = false;
+
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    const IOVariable &was = previous[i];
+    IOVariable &io = next[i];
+    changed[i] = !sameIdentity(was, io);
+    if (!changed[i]) {
+      io.state = was.state;
+      io.flag = was.flag;
+      // Timer and delayed DO 'value' is a preset; take the edited one
+      if (io.type != Timer && io.type != DigitalOutput) io.value = was.value;
+      continue;
+    }
+    if (was.type == Timer || was.type == DigitalOutput) timerStop(i);
+    if (io.type == Timer || io.type == DigitalInput) {
+      io.state = false;  // Not running / latched again below
+      io.flag = false;
+    }
+    if (was.status && was.type == DigitalOutput &&
+        !(io.status && io.type == DigitalOutput && io.gpio == was.gpio)) {
+      digitalWrite(was.gpio, LOW);  // Pin released by the new image
+    }
+    if (was.type == DigitalInput || io.type == DigitalInput) {
+      captureChanged = true;
+    }
+  }
+
+  if (captureChanged) stopInputCapture();
+  IOVariables = next;
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    if (changed[i]) configurePin(i);
+  }
+  if (captureChanged) startInputCapture();
+  updateAnalogInputs();
+  buildSchedule(esp_timer_get_time());  // Windows may have been edited
+  swapRuleProgram(spareProgram());
+}
+
+void swapLogicImage() {
+  swapWaiter = xTaskGetCurrentTaskHandle();
+  swapRequested.store(true, std::memory_order_release);
+  // Blocks instead of polling; a stray notification only loops once more
+  while (swapRequested.load(std::memory_order_acquire)) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+}
+// --- End Logic Image Swap ---
+
+void resetScanStatistics() {
+  scanStats.cycles = 0;
+  scanStats.overruns = 0;
+  scanStats.lastJitterUs = 0;
+  scanStats.maxJitterUs = 0;
+  scanStats.lastExecUs = 0;
+  scanStats.maxExecUs = 0;
+  scanStats.swaps = 0;
+  scanStats.lastSwapUs = 0;
+}
+
+void startScanEngine() {
+  resetScanStatistics();
+  xTaskCreatePinnedToCore(scanTaskFunction, "scanTask", SCAN_TASK_STACK, NULL,
+                          SCAN_TASK_PRIORITY, &scanTask, SCAN_TASK_CORE);
+}
+
+static void scanTaskFunction(void *pvParameters) {
+  esp_task_wdt_add(NULL);
+  configurePins();
+  startInputCapture();  // ISRs on this core, next to their consumer
+  startAnalogInputs();
+  compileRuleProgram(*activeProgram);  // Resolve IDs once, not every scan
+  startTimerService();
+  buildSchedule(esp_timer_get_time());
+  resetRuleEngine();
+
+  vTaskDelay(1);  // Align the schedule to a tick boundary
+  TickType_t lastWake = xTaskGetTickCount();
+  int64_t scheduledUs = esp_timer_get_time();
+
+  for (;;) {
+    uint8_t periodMs = defaultConfig.scanPeriodMs;
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(periodMs));
+    int64_t startUs = esp_timer_get_time();
+    scheduledUs += (int64_t)periodMs * 1000;
+    setEventTime(startUs);
+    if (scanStats.firstScanUs == 0) {
+      scanStats.firstScanUs = (uint32_t)startUs;  // esp_timer starts at boot
+      Serial.printf("First scan %u us after boot\n",
+                    (unsigned)scanStats.firstScanUs);
+    }
+
+    bool swapped = swapRequested.load(std::memory_order_acquire);
+    if (swapped) {
+      switchLogicImage();
+      scanStats.swaps++;
+      recordEvent(EVENT_CONFIG, EVENT_NO_SLOT, 0, 0, scanStats.swaps);
+      scanStats.lastSwapUs = (uint32_t)(esp_timer_get_time() - startUs);
+    }
+
+    // Input latch -> rule evaluation -> output commit
+    runScanCycle(startUs, scanStats.cycles);
+    // Whoever requested the swap reads the new image from here on
+    if (swapped) {
+      swapRequested.store(false, std::memory_order_release);
+      xTaskNotifyGive(swapWaiter);
+    }
+
+    int32_t jitterUs = (int32_t)(startUs - scheduledUs);
+    uint32_t execUs = (uint32_t)(esp_timer_get_time() - startUs);
+    scanStats.cycles++;
+    scanStats.lastJitterUs = jitterUs;
+    if (abs(jitterUs) > scanStats.maxJitterUs) {
+      scanStats.maxJitterUs = abs(jitterUs);
+    }
+    scanStats.lastExecUs = execUs;
+    if (execUs > scanStats.maxExecUs) scanStats.maxExecUs = execUs;
+    observeScan(jitterUs, execUs);
+    if (execUs > (uint32_t)periodMs * 1000) {
+      scanStats.overruns++;
+      // Resynchronise instead of bursting through the missed cycles
+      lastWake = xTaskGetTickCount();
+      scheduledUs = esp_timer_get_time();
+    }
+    esp_task_wdt_reset();
+  }
+}
@@ -0,0 +1,42 @@
+#ifndef SCAN_ENGINE_H
+#define SCAN_ENGINE_H
+
+#include <Arduino.h>
+
+#include "dataStructure.h"
+
+// Scan cycle period limits (milliseconds, FreeRTOS tick is 1 ms)
+#define DEFAULT_SCAN_PERIOD_MS 5
+#define MIN_SCAN_PERIOD_MS 1
+#define MAX_SCAN_PERIOD_MS 10
+
+#define SCAN_TASK_CORE 1  // Keep control away from WiFi/AsyncTCP on core 0
+#define SCAN_TASK_PRIORITY (configMAX_PRIORITIES - 2)
+#define SCAN_TASK_STACK 4096
+
+// Timing of the scan cycle, written only by the scan task
+struct scanStatistics {
+  uint32_t cycles;       // Completed scan cycles
+  uint32_t overruns;     // Cycles whose execution exceeded the period
+  int32_t lastJitterUs;  // Wake-up time minus scheduled time, last cycle
+  int32_t maxJitterUs;   // Largest absolute jitter seen
+  uint32_t lastExecUs;   // Latch + evaluate + commit time, last cycle
+  uint32_t maxExecUs;    // Largest execution time seen
+  uint32_t firstScanUs;  // Boot to start of the first cycle (not reset)
+  uint32_t swaps;        // Configuration images switched to
+  uint32_t lastSwapUs;   // Time the last switch took inside the scan
+};
+
+extern scanStatistics scanStats;
+
+void startScanEngine();  // Call once the configuration has been loaded
+void resetScanStatistics();
+
+// Hands the spare IOVariables image and spare program (both fully prepared)
+// to the scan task, which switches to them at the start of its next cycle.
+// Blocks until the switch is done and the first process image of the new
+// configuration is published, at most two scan periods. The wait uses the
+// calling task's notification value.
+void swapLogicImage();
+
+#endif  // SCAN_ENGINE_H
@@ -0,0 +1,164 @@
+#include "scheduler.h"
+
+#include <sys/time.h>
+#include <time.h>
+
+#include <atomic>
+
+#include "configJson.h"
+
+schedulerStatistics schedulerStats;
+
+struct scheduleEntry {
+  int64_t dueUs;    // esp_timer time of the next transition
+  time_t nextWall;  // Wall time of the next transition
+  schedule window;  // Copy, the network task may rewrite schedules[]
+  uint8_t slot;     // Schedule IOVariable
+};
+
+static scheduleEntry entries[MAX_SCHEDULES];  // Sorted by dueUs
+static uint8_t entryCount = 0;
+static std::atomic<bool> clockChanged(false);
+static std::atomic<bool> zoneChanged(false);
+static portMUX_TYPE zoneLock = portMUX_INITIALIZER_UNLOCKED;
+static char pendingZone[sizeof(defaultConfig.timeZone)];  // Under zoneLock
+
+// --- Window Math ---
+// Local time of 'minute' on the day 'day' days after 'today'
+static time_t windowEdge(const struct tm &today, int day, uint16_t minute) {
+  struct tm t = today;
+  t.tm_mday += day;
+  t.tm_hour = minute / 60;
+  t.tm_min = minute % 60;
+  t.tm_sec = 0;
+  t.tm_isdst = -1;  // Let mktime apply the DST rule of that day
+  return mktime(&t);
+}
+
+// Returns whether 'window' is open at 'now' and sets 'next' to its first
+// transition after 'now' (0 if it never opens)
+static bool evaluateWindow(const schedule &window, time_t now, time_t &next) {
+  struct tm today;
+  localtime_r(&now, &today);
+  bool open = false;
+  next = 0;
+  if (window.onMinute == window.offMinute) return false;
+  // Yesterday's window can still be open; a week ahead covers every mask
+  for (int day = -1; day <= 7; day++) {
+    if (!(window.days & (1 << ((today.tm_wday + day + 7) % 7)))) continue;
+    int closeDay = (window.offMinute > window.onMinute) ? day : day + 1;
+    time_t on = windowEdge(today, day, window.onMinute);
+    time_t off = windowEdge(today, closeDay, window.offMinute);
+    if (on <= now && now < off) open = true;
+    if (on > now && (next == 0 || on < next)) next = on;
+    if (off > now && (next == 0 || off < next)) next = off;
+  }
+  return open;
+}
+
+// esp_timer deadline of wall time 'wall', relative to the scan time
+static int64_t wallDeadline(time_t wall, int64_t nowUs) {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  int64_t wallUs = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+  return nowUs + ((int64_t)wall * 1000000 - wallUs);
+}
+// --- End Window Math ---
+
+// --- Sorted Set ---
+static void insertEntry(const scheduleEntry &entry) {
+  uint8_t i = entryCount++;
+  while (i > 0 && entries[i - 1].dueUs > entry.dueUs) {
+    entries[i] = entries[i - 1];
+    i--;
+  }
+  entries[i] = entry;
+}
+
+static void removeHead() {
+  entryCount--;
+  memmove(entries, entries + 1, entryCount * sizeof(scheduleEntry));
+}
+// --- End Sorted Set ---
+
+static const schedule *findSchedule(uint8_t num) {
+  for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+    if (schedules[i].num == num) return &schedules[i];
+  }
+  return nullptr;
+}
+
+// Scan task only, so no localtime_r()/mktime() runs while TZ changes
+static void applyPendingTimeZone() {
+  if (!zoneChanged.exchange(false, std::memory_order_acquire)) return;
+  char zone[sizeof(pendingZone)];
+  portENTER_CRITICAL(&zoneLock);
+  memcpy(zone, pendingZone, sizeof(zone));
+  portEXIT_CRITICAL(&zoneLock);
+  setenv("TZ", zone, 1);  // Allocates, so outside the critical section
+  tzset();
+}
+
+void buildSchedule(int64_t nowUs) {
+  clockChanged.store(false, std::memory_order_relaxed);
+  applyPendingTimeZone();
+  entryCount = 0;
+  time_t now = time(nullptr);
+  bool valid = now >= MIN_VALID_EPOCH;
+
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    IOVariable &io = IOVariables[i];
+    if (io.type != Schedule) continue;
+    const schedule *window = findSchedule(io.num);
+    bool open = false;
+    if (valid && io.status && window != nullptr) {
+      scheduleEntry entry;
+      open = evaluateWindow(*window, now, entry.nextWall);
+      if (entry.nextWall != 0) {
+        entry.dueUs = wallDeadline(entry.nextWall, nowUs);
+        entry.window = *window;
+        entry.slot = i;
+        insertEntry(entry);
+      }
+    }
+    io.state = open;
+  }
+  schedulerStats.rebuilds++;
+  schedulerStats.pending = entryCount;
+  schedulerStats.clockValid = valid;
+}
+
+void runScheduler(int64_t nowUs) {
+  if (clockChanged.load(std::memory_order_acquire) ||
+      zoneChanged.load(std::memory_order_acquire)) {
+    buildSchedule(nowUs);
+  }
+
+  while (entryCount > 0 && entries[0].dueUs <= nowUs) {
+    scheduleEntry entry = entries[0];
+    removeHead();
+    // esp_timer and the wall clock drift apart slowly; never evaluate
+    // before the transition the entry was due for
+    time_t now = time(nullptr);
+    if (now < entry.nextWall) now = entry.nextWall;
+    IOVariables[entry.slot].state =
+        evaluateWindow(entry.window, now, entry.nextWall);
+    schedulerStats.fired++;
+    if (entry.nextWall != 0) {
+      entry.dueUs = wallDeadline(entry.nextWall, nowUs);
+      insertEntry(entry);
+    }
+  }
+  schedulerStats.pending = entryCount;
+}
+
+void notifyClockChanged() {
+  clockChanged.store(true, std::memory_order_release);
+}
+
+void setScheduleTimeZone(const char *zone) {
+  portENTER_CRITICAL(&zoneLock);
+  strlcpy(pendingZone, zone, sizeof(pendingZone));
+  portEXIT_CRITICAL(&zoneLock);
+  zoneChanged.store(true, std::memory_order_release);
+}
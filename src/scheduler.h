@@ -0,0 +1,45 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+#include "dataStructure.h"
+
+// Calendar windows for Schedule IOVariables. Every enabled schedule has one
+// entry holding its next open/close transition, converted to an esp_timer
+// deadline, and the entries are kept sorted by that deadline. Each scan only
+// compares the earliest deadline with the scan time; local-time calendar
+// math runs when an entry fires, after a configuration swap or when the
+// wall clock is stepped (NTP sync, RTC restore), never per scan.
+//
+// The scan task is the only user of local time, and newlib keeps a single
+// TZ state that is not safe to change while another task converts times.
+// So TZ is set here too, at a scan boundary: setScheduleTimeZone() only
+// hands the string over.
+//
+// Until the wall clock holds a plausible date every Schedule stays false.
+
+#define MIN_VALID_EPOCH 1704067200  // 2024-01-01, older means "not set"
+
+struct schedulerStatistics {
+  uint32_t rebuilds;  // Full recomputations (swap, clock step)
+  uint32_t fired;     // Entries that reached their deadline
+  uint8_t pending;    // Entries in the sorted set
+  bool clockValid;    // Wall clock was plausible at the last rebuild
+};
+
+extern schedulerStatistics schedulerStats;
+
+// Scan task only. buildSchedule() recomputes every entry from the current
+// image; runScheduler() updates the Schedule states that are due.
+void buildSchedule(int64_t nowUs);
+void runScheduler(int64_t nowUs);
+
+// Any task: the wall clock was set, rebuild at the next scan
+void notifyClockChanged();
+
+// Any task: apply POSIX TZ string 'zone' and rebuild at the next scan (or
+// at buildSchedule() if that comes first)
+void setScheduleTimeZone(const char *zone);
+
+#endif  // SCHEDULER_H
@@ -0,0 +1,48 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <Arduino.h>
+
+#include <atomic>
+
+// Lock-free single-producer / single-consumer ring buffer. The producer may
+// be an ISR; neither side ever blocks. Capacity must be a power of two and
+// one slot is kept free to tell "full" from "empty".
+template <typename T, uint16_t CAPACITY>
+class spscRing {
+  static_assert((CAPACITY & (CAPACITY - 1)) == 0,
+                "spscRing capacity must be a power of two");
+
+ public:
+  // Producer side. Returns false (item dropped) when the ring is full.
+  inline __attribute__((always_inline)) bool push(const T &item) {
+    uint16_t head = head_.load(std::memory_order_relaxed);
+    uint16_t next = (head + 1) & (CAPACITY - 1);
+    if (next == tail_.load(std::memory_order_acquire)) return false;
+    items_[head] = item;
+    head_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false when the ring is empty.
+  inline bool pop(T &item) {
+    uint16_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) return false;
+    item = items_[tail];
+    tail_.store((tail + 1) & (CAPACITY - 1), std::memory_order_release);
+    return true;
+  }
+
+  inline uint16_t size() const {
+    return (head_.load(std::memory_order_acquire) -
+            tail_.load(std::memory_order_acquire)) &
+           (CAPACITY - 1);
+  }
+
+ private:
+  T items_[CAPACITY];
+  std::atomic<uint16_t> head_{0};  // Next slot the producer writes
+  std::atomic<uint16_t> tail_{0};  // Next slot the consumer reads
+};
+
+#endif  // SPSC_RING_H
@@ -0,0 +1,75 @@
+#include "timeSync.h"
+
+#include <RTClib.h>
+#include <WiFi.h>
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <atomic>
+
+#include "configJson.h"
+#include "scheduler.h"
+
+timeSyncStatistics timeSyncStats;
+
+static RTC_DS3231 rtc;  // Holds UTC, local time comes from TZ
+static std::atomic<bool> syncPending(false);
+static bool sntpStarted = false;
+static char appliedServer[sizeof(defaultConfig.ntpServer)] = "";
+static char appliedZone[sizeof(defaultConfig.timeZone)] = "";
+
+// Runs in the lwIP task; the network task does the I2C write
+static void onTimeSync(struct timeval *tv) {
+  syncPending.store(true, std::memory_order_release);
+}
+
+// The scan task sets TZ (scheduler.h); this task never touches it
+static void applyTimeZone() {
+  strlcpy(appliedZone, defaultConfig.timeZone, sizeof(appliedZone));
+  setScheduleTimeZone(appliedZone);
+}
+
+// configTzTime() without its setenv("TZ")/tzset()
+static void startSntp(const char *server) {
+  if (sntp_enabled()) sntp_stop();
+  sntp_setoperatingmode(SNTP_OPMODE_POLL);
+  sntp_setservername(0, (char *)server);  // Kept by pointer
+  sntp_init();
+}
+
+void startTimeSync() {
+  applyTimeZone();
+  timeSyncStats.rtcPresent = rtc.begin();
+  if (timeSyncStats.rtcPresent && !rtc.lostPower()) {
+    struct timeval tv = {(time_t)rtc.now().unixtime(), 0};
+    settimeofday(&tv, nullptr);
+    timeSyncStats.rtcRestored = true;
+    Serial.println("Clock restored from DS3231");
+  }
+  sntp_set_time_sync_notification_cb(onTimeSync);
+}
+
+void serviceTimeSync() {
+  bool changed = false;
+  if (strcmp(appliedZone, defaultConfig.timeZone) != 0) {
+    applyTimeZone();  // Same instant, other local windows
+  }
+  if (WiFi.status() == WL_CONNECTED &&
+      (!sntpStarted || strcmp(appliedServer, defaultConfig.ntpServer) != 0)) {
+    strlcpy(appliedServer, defaultConfig.ntpServer, sizeof(appliedServer));
+    startSntp(appliedServer);  // Restarts SNTP, non-blocking
+    sntpStarted = true;
+  }
+  if (syncPending.exchange(false, std::memory_order_acquire)) {
+    timeSyncStats.syncs++;
+    timeSyncStats.lastSyncUs = (uint32_t)esp_timer_get_time();
+    if (timeSyncStats.rtcPresent) {
+      rtc.adjust(DateTime((uint32_t)time(nullptr)));
+      timeSyncStats.rtcWrites++;
+    }
+    changed = true;
+  }
+  if (changed) notifyClockChanged();
+}
@@ -0,0 +1,31 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <Arduino.h>
+
+// Wall clock for the Schedule IOVariables. At boot the system clock is set
+// from the DS3231 (if present and not reset by a power loss), so schedules
+// run without WiFi. Once WiFi is up the core's SNTP client keeps the clock
+// in sync in the background and every sync is written back to the DS3231.
+// Each step of the clock makes the scheduler rebuild its deadlines. Time
+// zone changes are handed to the scheduler, which applies TZ on the scan
+// task, the only task that converts to local time.
+
+#define DEFAULT_NTP_SERVER "pool.ntp.org"
+// POSIX TZ string, e.g. "CET-1CEST,M3.5.0,M10.5.0/3"
+#define DEFAULT_TIME_ZONE "UTC0"
+
+struct timeSyncStatistics {
+  uint32_t syncs;       // SNTP updates applied
+  uint32_t rtcWrites;   // DS3231 updates after a sync
+  uint32_t lastSyncUs;  // esp_timer time of the last SNTP update
+  bool rtcPresent;      // DS3231 answered at boot
+  bool rtcRestored;     // System clock was set from the DS3231
+};
+
+extern timeSyncStatistics timeSyncStats;
+
+void startTimeSync();    // Before the scan engine: TZ and RTC restore
+void serviceTimeSync();  // Network task loop: SNTP start, RTC write-back
+
+#endif  // TIME_SYNC_H
@@ -0,0 +1,167 @@
+#include "timerService.h"
+
+#include <esp_timer.h>
+
+#include <atomic>
+
+#define NO_DEADLINE UINT64_MAX
+
+timerServiceStatistics timerServiceStats;
+
+struct timerEntry {
+  uint64_t deadlineUs;
+  uint64_t periodUs;  // 0 = one-shot
+  bool armed;
+};
+
+static timerEntry entries[MAX_IO_VARIABLES];
+static std::atomic<uint32_t> expiredMask[TIMER_MASK_WORDS];
+static esp_timer_handle_t hardwareTimer = nullptr;
+static portMUX_TYPE timerLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Guarded by timerLock
+static uint8_t order[MAX_IO_VARIABLES];  // Armed slots, earliest first
+static uint8_t orderCount = 0;
+static uint64_t hardwareDeadlineUs = NO_DEADLINE;  // What esp_timer is set to
+static bool arming = false;       // A task is re-arming esp_timer
+static bool rearmNeeded = false;  // The earliest deadline changed meanwhile
+
+// --- Sorted Set (caller holds timerLock) ---
+static void insertSlot(uint8_t slot) {
+  uint64_t deadlineUs = entries[slot].deadlineUs;
+  uint8_t i = orderCount++;
+  while (i > 0 && entries[order[i - 1]].deadlineUs > deadlineUs) {
+    order[i] = order[i - 1];
+    i--;
+  }
+  order[i] = slot;
+}
+
+static void removeSlot(uint8_t slot) {
+  for (uint8_t i = 0; i < orderCount; i++) {
+    if (order[i] != slot) continue;
+    orderCount--;
+    memmove(order + i, order + i + 1, orderCount - i);
+    return;
+  }
+}
+// --- End Sorted Set ---
+
+// Sets esp_timer to the earliest deadline. esp_timer takes its own locks, so
+// this runs outside timerLock; whoever is arming loops until no other task
+// changed the earliest deadline in between.
+static void armHardware() {
+  portENTER_CRITICAL(&timerLock);
+  if (arming) {
+    rearmNeeded = true;
+    portEXIT_CRITICAL(&timerLock);
+    return;
+  }
+  arming = true;
+  do {
+    rearmNeeded = false;
+    uint64_t deadlineUs =
+        orderCount > 0 ? entries[order[0]].deadlineUs : NO_DEADLINE;
+    hardwareDeadlineUs = deadlineUs;
+    portEXIT_CRITICAL(&timerLock);
+
+    esp_timer_stop(hardwareTimer);  // Fails harmlessly when idle
+    if (deadlineUs != NO_DEADLINE) {
+      uint64_t nowUs = esp_timer_get_time();
+      esp_timer_start_once(hardwareTimer,
+                           deadlineUs > nowUs ? deadlineUs - nowUs : 0);
+    }
+    portENTER_CRITICAL(&timerLock);
+  } while (rearmNeeded);
+  arming = false;
+  portEXIT_CRITICAL(&timerLock);
+}
+
+static void clearExpired(uint8_t slot) {
+  expiredMask[slot / 32].fetch_and(~(1UL << (slot % 32)));
+}
+
+// Only the due entries at the head of the sorted set are visited
+static void timerCallback(void * /* arg */) {
+  portENTER_CRITICAL(&timerLock);
+  uint64_t nowUs = esp_timer_get_time();
+  timerServiceStats.callbacks++;
+  while (orderCount > 0 && entries[order[0]].deadlineUs <= nowUs) {
+    uint8_t slot = order[0];
+    timerEntry &entry = entries[slot];
+    orderCount--;
+    memmove(order, order + 1, orderCount);
+    uint32_t latenessUs = (uint32_t)(nowUs - entry.deadlineUs);
+    if (latenessUs > timerServiceStats.maxLatenessUs) {
+      timerServiceStats.maxLatenessUs = latenessUs;
+    }
+    expiredMask[slot / 32].fetch_or(1UL << (slot % 32));
+    timerServiceStats.expirations++;
+    if (entry.periodUs > 0) {
+      do {  // Keep phase; periods missed while late collapse into one
+        entry.deadlineUs += entry.periodUs;
+      } while (entry.deadlineUs <= nowUs);
+      insertSlot(slot);
+    } else {
+      entry.armed = false;
+    }
+  }
+  portEXIT_CRITICAL(&timerLock);
+  armHardware();
+}
+
+void startTimerService() {
+  if (hardwareTimer == nullptr) {
+    esp_timer_create_args_t args = {};
+    args.callback = timerCallback;
+    args.arg = nullptr;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "timerService";
+    esp_timer_create(&args, &hardwareTimer);
+  }
+  resetTimerService();
+  timerServiceStats.expirations = 0;
+  timerServiceStats.callbacks = 0;
+  timerServiceStats.maxLatenessUs = 0;
+}
+
+void resetTimerService() {
+  portENTER_CRITICAL(&timerLock);
+  for (uint8_t i = 0; i < MAX_IO_VARIABLES; i++) {
+    entries[i].armed = false;
+  }
+  orderCount = 0;
+  for (uint8_t w = 0; w < TIMER_MASK_WORDS; w++) {
+    expiredMask[w].store(0);
+  }
+  portEXIT_CRITICAL(&timerLock);
+  if (hardwareTimer != nullptr) armHardware();
+}
+
+void timerStart(uint8_t slot, uint64_t delayUs, uint64_t periodUs) {
+  portENTER_CRITICAL(&timerLock);
+  uint64_t nowUs = esp_timer_get_time();
+  timerEntry &entry = entries[slot];
+  if (entry.armed) removeSlot(slot);
+  entry.deadlineUs = nowUs + delayUs;
+  entry.periodUs = periodUs;
+  entry.armed = true;
+  insertSlot(slot);
+  clearExpired(slot);  // A restart supersedes an expiry not yet consumed
+  bool earlier = entry.deadlineUs < hardwareDeadlineUs;
+  portEXIT_CRITICAL(&timerLock);
+  if (earlier) armHardware();
+}
+
+void timerStop(uint8_t slot) {
+  portENTER_CRITICAL(&timerLock);
+  if (entries[slot].armed) removeSlot(slot);
+  entries[slot].armed = false;  // Hardware timer may still fire; it re-arms
+  clearExpired(slot);
+  portEXIT_CRITICAL(&timerLock);
+}
+
+uint32_t takeExpiredTimers(uint8_t word) {
+  if (expiredMask[word].load(std::memory_order_relaxed) == 0) return 0;
+  return expiredMask[word].exchange(0);
+}
@@ -0,0 +1,38 @@
+#ifndef TIMER_SERVICE_H
+#define TIMER_SERVICE_H
+
+#include <Arduino.h>
+
+#include "dataStructure.h"
+
+// Deadline scheduler for Timer IOVariables and DigitalOutput startDelay /
+// autoOff, driven by one esp_timer. Armed slots are kept sorted by deadline;
+// the hardware timer is only re-armed when a new deadline is earlier than
+// the armed one, and a callback visits just the due entries at the head.
+// esp_timer is (re)armed outside the service's spinlock, because it takes
+// its own locks. Expiry is timestamped in the esp_timer callback
+// (microsecond resolution, repeating timers keep their phase) and handed to
+// the scan task as a bitmask per IO slot.
+
+#define TIMER_MASK_WORDS ((MAX_IO_VARIABLES + 31) / 32)
+
+struct timerServiceStatistics {
+  uint32_t expirations;   // Deadlines reached
+  uint32_t callbacks;     // Hardware timer interrupts handled
+  uint32_t maxLatenessUs; // Callback time minus deadline, worst case
+};
+
+extern timerServiceStatistics timerServiceStats;
+
+void startTimerService();
+void resetTimerService();  // Stop every entry and clear pending expiries
+
+// Arms 'slot' to expire after delayUs; periodUs > 0 re-arms it from the
+// previous deadline every period (repeating Timers).
+void timerStart(uint8_t slot, uint64_t delayUs, uint64_t periodUs);
+void timerStop(uint8_t slot);
+
+// Returns and clears the expiry bits of word 'word' (slot = word*32 + bit)
+uint32_t takeExpiredTimers(uint8_t word);
+
+#endif  // TIMER_SERVICE_H
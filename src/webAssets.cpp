@@ -0,0 +1,105 @@
+#include "webAssets.h"
+
+#include <LittleFS.h>
+
+#define GZIP_TRAILER_SIZE 8  // uint32 CRC32, uint32 uncompressed size
+
+struct webAsset {
+  char path[WEB_ASSET_PATH_SIZE];  // URL, the file is path + ".gz"
+  char tag[WEB_ASSET_TAG_SIZE];    // Bare ETag value, also the ?v= version
+};
+
+static webAsset webAssets[MAX_WEB_ASSETS];
+static uint8_t webAssetCount = 0;
+
+// Content hash of a gzip file from its trailer, without inflating it. Must
+// match asset_tag() in scripts/web_assets.py.
+static bool webAssetTag(File &file, char *tag) {
+  if (file.size() < GZIP_TRAILER_SIZE) return false;
+  uint8_t trailer[GZIP_TRAILER_SIZE];
+  if (!file.seek(file.size() - GZIP_TRAILER_SIZE) ||
+      file.read(trailer, GZIP_TRAILER_SIZE) != GZIP_TRAILER_SIZE) {
+    return false;
+  }
+  uint32_t crc = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) |
+                 ((uint32_t)trailer[3] << 24);
+  uint32_t size = trailer[4] | (trailer[5] << 8) | (trailer[6] << 16) |
+                  ((uint32_t)trailer[7] << 24);
+  snprintf(tag, WEB_ASSET_TAG_SIZE, "%08lx-%lx", (unsigned long)crc,
+           (unsigned long)size);
+  return true;
+}
+
+// True if the request names exactly the content we hold
+static bool matchesTag(AsyncWebServerRequest *request, const char *name,
+                       bool header, const webAsset &asset) {
+  if (header) {
+    if (!request->hasHeader(name)) return false;
+    // If-None-Match carries the quoted value; a list or W/ prefix is fine
+    return strstr(request->getHeader(name)->value().c_str(), asset.tag) !=
+           nullptr;
+  }
+  if (!request->hasParam(name)) return false;
+  return strcmp(request->getParam(name)->value().c_str(), asset.tag) == 0;
+}
+
+static void serveWebAsset(AsyncWebServerRequest *request,
+                          const webAsset &asset) {
+  char etag[WEB_ASSET_TAG_SIZE + 2];
+  snprintf(etag, sizeof(etag), "\"%s\"", asset.tag);
+  const char *cacheControl = matchesTag(request, "v", false, asset)
+                                 ? WEB_CACHE_IMMUTABLE
+                                 : WEB_CACHE_REVALIDATE;
+
+  AsyncWebServerResponse *response;
+  if (matchesTag(request, "If-None-Match", true, asset)) {
+    response = request->beginResponse(304);
+  } else {
+    // Only <path>.gz exists, so the file response opens it and adds
+    // Content-Encoding: gzip; the content type follows the plain path
+    response = request->beginResponse(LittleFS, asset.path, String());
+  }
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", cacheControl);
+  request->send(response);
+}
+
+uint8_t setupWebAssets(AsyncWebServer &server) {
+  webAssetCount = 0;
+  File root = LittleFS.open("/");
+  if (!root || !root.isDirectory()) return 0;
+
+  for (File file = root.openNextFile(); file; file = root.openNextFile()) {
+    const char *name = file.path();
+    size_t length = strlen(name);
+    if (file.isDirectory() || length < 4 ||
+        strcmp(name + length - 3, ".gz") != 0 ||
+        length - 3 >= WEB_ASSET_PATH_SIZE) {
+      continue;
+    }
+    if (webAssetCount >= MAX_WEB_ASSETS) {
+      Serial.printf("Web asset ignored (table full): %s\n", name);
+      continue;
+    }
+    webAsset &asset = webAssets[webAssetCount];
+    if (!webAssetTag(file, asset.tag)) {
+      Serial.printf("Web asset ignored (bad gzip): %s\n", name);
+      continue;
+    }
+    memcpy(asset.path, name, length - 3);
+    asset.path[length - 3] = '\0';
+
+    uint8_t index = webAssetCount++;
+    server.on(asset.path, HTTP_GET, [index](AsyncWebServerRequest *request) {
+      serveWebAsset(request, webAssets[index]);
+    });
+    if (strcmp(asset.path, WEB_INDEX_PATH) == 0) {
+      server.on("/", HTTP_GET, [index](AsyncWebServerRequest *request) {
+        serveWebAsset(request, webAssets[index]);
+      });
+    }
+  }
+  root.close();
+  Serial.printf("Web assets: %u registered\n", webAssetCount);
+  return webAssetCount;
+}
@@ -0,0 +1,28 @@
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+// Static web UI served from gzipped files in the LittleFS root (built by
+// scripts/web_assets.py). Every <name>.gz is served at /<name> with
+// Content-Encoding: gzip and a strong ETag taken from its gzip trailer, so a
+// browser revalidating an unchanged file gets an empty 304.
+//
+// index.html links the other assets as /<name>?v=<tag>; requests carrying
+// the current tag are cacheable as immutable, everything else (index.html,
+// unversioned URLs) must revalidate on each use.
+
+#define MAX_WEB_ASSETS 16
+#define WEB_ASSET_PATH_SIZE 32  // LittleFS name limit plus the leading '/'
+#define WEB_ASSET_TAG_SIZE 18   // "crc32-size" in hex plus terminator
+#define WEB_INDEX_PATH "/index.html"
+
+#define WEB_CACHE_IMMUTABLE "public, max-age=31536000, immutable"
+#define WEB_CACHE_REVALIDATE "no-cache"
+
+// Scans LittleFS and registers a GET handler per asset, plus "/" for
+// index.html. Returns the number of assets registered.
+uint8_t setupWebAssets(AsyncWebServer &server);
+
+#endif  // WEB_ASSETS_H
@@ -0,0 +1,72 @@
+// Host tests of the configuration JSON parser: pio test -e native_test
+#include <unity.h>
+
+#include "configJson.h"
+
+static configJsonParser parser;
+
+// Mirrors applyParsedConfig(): the staged copy only goes live if the whole
+// body parsed
+static bool upload(const char *body) {
+  parser.begin();
+  parser.feed(body, strlen(body));
+  if (!parser.finish()) return false;
+  parser.commit();
+  return true;
+}
+
+static bool uploadPart(const char *section, uint16_t index, const char *body) {
+  parser.beginPart(section, index, true);
+  parser.feed(body, strlen(body));
+  if (!parser.finish()) return false;
+  parser.commit();
+  return true;
+}
+
+void setUp() {
+  strlcpy(defaultConfig.SSID, "plant-wifi", sizeof(defaultConfig.SSID));
+  strlcpy(defaultConfig.PASS, "secret", sizeof(defaultConfig.PASS));
+  strlcpy(defaultConfig.DeviceName, "press-3", sizeof(defaultConfig.DeviceName));
+  defaultConfig.run = true;
+}
+
+void tearDown() {}
+
+static void test_scalar_root_is_refused() {
+  static const char *const bodies[] = {"5", "\"x\"", "null", "true", "[]"};
+  for (const char *body : bodies) {
+    TEST_ASSERT_FALSE(upload(body));
+    TEST_ASSERT_EQUAL_STRING("plant-wifi", defaultConfig.SSID);
+    TEST_ASSERT_EQUAL_STRING("secret", defaultConfig.PASS);
+    TEST_ASSERT_EQUAL_STRING("press-3", defaultConfig.DeviceName);
+    TEST_ASSERT_TRUE(defaultConfig.run);
+  }
+}
+
+static void test_object_root_is_accepted() {
+  TEST_ASSERT_TRUE(upload(generateJsonConfigString().c_str()));
+  TEST_ASSERT_EQUAL_STRING("plant-wifi", defaultConfig.SSID);
+  TEST_ASSERT_TRUE(upload("{}"));  // Device settings start blank
+  TEST_ASSERT_EQUAL_STRING("", defaultConfig.SSID);
+}
+
+static void test_part_root_must_match_section() {
+  TEST_ASSERT_FALSE(uploadPart("ioVariables", CONFIG_NO_INDEX, "{}"));
+  TEST_ASSERT_FALSE(uploadPart("ioVariables", CONFIG_NO_INDEX, "5"));
+  TEST_ASSERT_TRUE(uploadPart("ioVariables", CONFIG_NO_INDEX, "[]"));
+  TEST_ASSERT_FALSE(uploadPart("ioVariables", 0, "[]"));
+  TEST_ASSERT_FALSE(uploadPart("ioVariables", 0, "null"));
+  TEST_ASSERT_TRUE(uploadPart("ioVariables", 0, "{}"));
+  TEST_ASSERT_FALSE(uploadPart("deviceSettings", CONFIG_NO_INDEX, "[]"));
+  TEST_ASSERT_FALSE(uploadPart("deviceSettings", CONFIG_NO_INDEX, "\"x\""));
+  TEST_ASSERT_TRUE(uploadPart("deviceSettings", CONFIG_NO_INDEX, "{}"));
+  TEST_ASSERT_EQUAL_STRING("plant-wifi", defaultConfig.SSID);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_scalar_root_is_refused);
+  RUN_TEST(test_object_root_is_accepted);
+  RUN_TEST(test_part_root_must_match_section);
+  return UNITY_END();
+}
@@ -0,0 +1,101 @@
+// Host tests of the configuration validator: pio test -e native_test
+#include <unity.h>
+
+#include "configValidator.h"
+
+static validationReport report;
+
+static void validate() { validateConfig(liveConfigView(), report); }
+
+// True if a stored issue of 'severity' reads exactly 'message'
+static bool reported(issueSeverity severity, const char *message) {
+  for (uint8_t i = 0; i < report.stored; i++) {
+    if (report.issues[i].severity == severity &&
+        strcmp(report.issues[i].message, message) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void enableSchedule(uint8_t index, uint16_t onMinute,
+                           uint16_t offMinute) {
+  IOVariables[FIRST_SCHEDULE + index].status = true;
+  schedules[index].onMinute = onMinute;
+  schedules[index].offMinute = offMinute;
+}
+
+void setUp() {
+  CreateDefaultIOVariables();
+  InitializeDefaultLogicComponents();
+}
+
+void tearDown() {}
+
+static void test_defaults_are_valid() {
+  validate();
+  TEST_ASSERT_EQUAL_UINT(0, report.errors);
+  TEST_ASSERT_EQUAL_UINT(0, report.warnings);
+}
+
+static void test_schedule_with_window_is_valid() {
+  enableSchedule(0, 6 * 60, 18 * 60);
+  validate();
+  TEST_ASSERT_EQUAL_UINT(0, report.errors);
+  TEST_ASSERT_EQUAL_UINT(0, report.warnings);
+}
+
+static void test_enabled_schedule_without_window() {
+  enableSchedule(0, 6 * 60, 18 * 60);
+  schedules[0].num = 0;  // Unused entry
+  validate();
+  TEST_ASSERT_EQUAL_UINT(1, report.errors);
+  TEST_ASSERT_TRUE(reported(ISSUE_ERROR, "Schedule 1: no window"));
+
+  schedules[0].num = 1;
+  schedules[0].offMinute = schedules[0].onMinute;
+  validate();
+  TEST_ASSERT_EQUAL_UINT(0, report.errors);
+  TEST_ASSERT_TRUE(reported(ISSUE_WARNING, "Schedule 1: window never opens"));
+}
+
+static void test_window_without_enabled_schedule() {
+  schedules[0].onMinute = 6 * 60;  // Schedule 1 stays disabled
+  schedules[0].offMinute = 18 * 60;
+  validate();
+  TEST_ASSERT_EQUAL_UINT(1, report.errors);
+  TEST_ASSERT_TRUE(reported(ISSUE_ERROR,
+                            "Schedule window 1: Schedule missing or disabled"));
+
+  schedules[0].num = 200;  // No Schedule has this number
+  validate();
+  TEST_ASSERT_EQUAL_UINT(1, report.errors);
+  TEST_ASSERT_TRUE(reported(
+      ISSUE_ERROR, "Schedule window 200: Schedule missing or disabled"));
+}
+
+static void test_duplicate_schedule_window() {
+  enableSchedule(0, 6 * 60, 18 * 60);
+  schedules[1].num = 1;
+  validate();
+  TEST_ASSERT_EQUAL_UINT(1, report.errors);
+  TEST_ASSERT_TRUE(reported(ISSUE_ERROR, "Schedule window 1: ID used twice"));
+}
+
+static void test_duplicate_io_variable_num() {
+  IOVariables[FIRST_SOFTIO + 1].num = IOVariables[FIRST_SOFTIO].num;
+  validate();
+  TEST_ASSERT_EQUAL_UINT(1, report.errors);
+  TEST_ASSERT_TRUE(reported(ISSUE_ERROR, "SoftIO 1: ID used twice"));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_defaults_are_valid);
+  RUN_TEST(test_schedule_with_window_is_valid);
+  RUN_TEST(test_enabled_schedule_without_window);
+  RUN_TEST(test_window_without_enabled_schedule);
+  RUN_TEST(test_duplicate_schedule_window);
+  RUN_TEST(test_duplicate_io_variable_num);
+  return UNITY_END();
+}